@@ -0,0 +1,205 @@
+/**
+ * @file asynccheck.cpp
+ * @brief Runs AsyncRingBuffer coroutines and threads together through an executor (C++20)
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <condition_variable>
+
+#include "asyncringbuffer.h"
+
+
+using namespace rtos;
+using namespace std;
+
+
+/**
+ * @brief 확인 변수
+ */
+namespace CHECK_PARAM {
+
+    const int ITEM_COUNT = 100000; // 각 경우에 주고 받을 데이터 개수
+    const size_t BUFFER_SIZE = 4;
+
+}; // CHECK_PARAM
+
+
+/**
+ * @brief 재개할 coroutine을 모아 두었다가 전용 쓰레드에서 재개하는 Executor.
+ */
+class ThreadExecutor : public Executor {
+
+    private:
+        deque<coroutine_handle<> > _handles;
+        mutex _mutex;
+        condition_variable _notEmpty;
+        bool _isStopping;
+        atomic<size_t> _resumed; // 재개한 횟수
+        thread _worker;
+
+        void run() {
+
+            unique_lock<mutex> lock(_mutex);
+
+            while (true) {
+                _notEmpty.wait(lock, [this]() { return _isStopping || !_handles.empty(); });
+                if (_handles.empty())
+                    return;
+
+                coroutine_handle<> handle = _handles.front();
+                _handles.pop_front();
+                lock.unlock();
+
+                _resumed.fetch_add(1, memory_order_relaxed);
+                handle.resume();
+
+                lock.lock();
+            }
+        }
+
+    public:
+        ThreadExecutor(): _isStopping(false), _resumed(0), _worker(&ThreadExecutor::run, this) {}
+
+        ~ThreadExecutor() {
+            unique_lock<mutex> lock(_mutex);
+            _isStopping = true;
+            lock.unlock();
+            _notEmpty.notify_one();
+            _worker.join();
+        }
+
+        void execute(coroutine_handle<> handle) override {
+            unique_lock<mutex> lock(_mutex);
+            _handles.push_back(handle);
+            lock.unlock();
+            _notEmpty.notify_one();
+        }
+
+        size_t resumed() const {
+            return _resumed.load(memory_order_relaxed);
+        }
+
+}; // ThreadExecutor
+
+
+/**
+ * @brief 바로 시작하고 끝나면 스스로 해제되는 coroutine. 끝났음은 done으로 알린다.
+ */
+struct Task {
+
+    struct promise_type {
+        Task get_return_object() { return Task(); }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+
+}; // Task
+
+
+Task produce(AsyncRingBuffer& buffer, Executor& executor, atomic<bool>& done) {
+    for (int i=0; i<CHECK_PARAM::ITEM_COUNT; ++i)
+        co_await buffer.asyncPut(i, executor);
+    done.store(true);
+}
+
+
+Task consume(AsyncRingBuffer& buffer, Executor& executor, atomic<bool>& done, atomic<int>& errors) {
+    for (int i=0; i<CHECK_PARAM::ITEM_COUNT; ++i) {
+        int item = co_await buffer.asyncGet(executor);
+        if (item != i)
+            errors.fetch_add(1);
+    }
+    done.store(true);
+}
+
+
+void waitFor(const atomic<bool>& done) {
+    while (!done.load())
+        this_thread::yield();
+}
+
+
+/**
+ * @brief 결과를 출력하고 실패 여부를 반환한다.
+ */
+bool report(const char* name, int errors, size_t resumed) {
+    // coroutine이 한 번도 멈추지 않았다면 executor를 거친 재개를 확인하지 못한 것이다.
+    bool isFailed = errors != 0 || resumed == 0;
+    printf("%-28s errors %d, resumed %zu: %s\n", name, errors, resumed, isFailed ? "FAIL" : "ok");
+    return isFailed;
+}
+
+
+int main() {
+
+    bool isFailed = false;
+
+    // coroutine producer, coroutine consumer
+    {
+        ThreadExecutor executor;
+        AsyncRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+        atomic<bool> produced(false), consumed(false);
+        atomic<int> errors(0);
+
+        consume(buffer, executor, consumed, errors);
+        produce(buffer, executor, produced);
+        waitFor(produced);
+        waitFor(consumed);
+        isFailed |= report("coroutine -> coroutine", errors.load(), executor.resumed());
+    }
+
+    // coroutine producer, 쓰레드 consumer (getFromNotEmptyBuffer)
+    {
+        ThreadExecutor executor;
+        AsyncRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+        atomic<bool> produced(false);
+        int errors = 0;
+
+        produce(buffer, executor, produced);
+        for (int i=0; i<CHECK_PARAM::ITEM_COUNT; ++i)
+            if (buffer.getFromNotEmptyBuffer() != i)
+                ++errors;
+        waitFor(produced);
+        isFailed |= report("coroutine -> thread", errors, executor.resumed());
+    }
+
+    // 쓰레드 producer (putWithoutOverride), coroutine consumer
+    {
+        ThreadExecutor executor;
+        AsyncRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+        atomic<bool> consumed(false);
+        atomic<int> errors(0);
+
+        consume(buffer, executor, consumed, errors);
+        for (int i=0; i<CHECK_PARAM::ITEM_COUNT; ++i)
+            buffer.putWithoutOverride(i);
+        waitFor(consumed);
+        isFailed |= report("thread -> coroutine", errors.load(), executor.resumed());
+    }
+
+    // 크기 0은 1로 만들어지므로 멈춘 coroutine도 깨어난다.
+    {
+        ThreadExecutor executor;
+        AsyncRingBuffer buffer(0);
+        atomic<bool> produced(false), consumed(false);
+        atomic<int> errors(0);
+
+        produce(buffer, executor, produced);
+        consume(buffer, executor, consumed, errors);
+        waitFor(produced);
+        waitFor(consumed);
+        isFailed |= report("coroutine -> coroutine (n=0)", errors.load(), executor.resumed());
+    }
+
+    return isFailed ? 1 : 0;
+}
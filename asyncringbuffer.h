@@ -0,0 +1,407 @@
+/**
+ * @file asyncringbuffer.h
+ * @brief Header-only RingBuffer with C++20 coroutine awaitables
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _ASYNC_RING_BUFFER_H_
+#define _ASYNC_RING_BUFFER_H_
+
+// C++20 coroutine이 필요하다. C++11로 빌드하는 경우에는 아무것도 선언하지 않는다.
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <coroutine>
+#include <condition_variable>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 대기하던 coroutine을 재개할 곳. 쓰레드 풀, event loop 등에 맞게 상속한다.
+     */
+    class Executor {
+
+        public:
+            virtual ~Executor() {}
+
+            /**
+             * @brief handle을 재개한다. 버퍼의 lock을 놓은 뒤, 상태를 바꾼 쓰레드에서 호출된다.
+             */
+            virtual void execute(coroutine_handle<> handle) = 0;
+
+    }; // Executor
+
+
+    /**
+     * @brief 상태를 바꾼 쓰레드에서 바로 재개한다.
+     */
+    class InlineExecutor : public Executor {
+
+        public:
+            void execute(coroutine_handle<> handle) override {
+                handle.resume();
+            }
+
+    }; // InlineExecutor
+
+
+    /**
+     * @brief co_await로 기다릴 수 있는 RingBuffer.
+     *
+     * asyncPut, asyncGet은 buffer가 가득 찼거나 비어 있으면 쓰레드 대신 coroutine을 멈추고
+     * 대기열에 넣는다. 상대방이 공간이나 데이터를 만들면 기다리던 coroutine에게 직접 넘겨준 뒤
+     * (다른 쓰레드가 가로챌 수 없다) 지정한 Executor에서 재개한다. 대기열은 FIFO이다.
+     *
+     * put, tryPut, get, tryGet, putWithoutOverride, getFromNotEmptyBuffer는 RingBuffer와 같은 의미의 동기 함수이며,
+     * 기다리는 coroutine도 깨운다. 따라서 쓰레드와 coroutine이 하나의 버퍼를 함께 사용할 수 있다.
+     * 공간이나 데이터는 대기 중인 coroutine에게 먼저 넘겨주고, 남으면 condition variable로 쓰레드를 깨운다.
+     *
+     * 버퍼 크기는 최소 1이다. 0을 지정하면 1로 만든다.
+     */
+    class AsyncRingBuffer {
+
+        private:
+            /**
+             * @brief 멈춘 coroutine 하나. awaiter 안에 있으므로 따로 할당하지 않는다.
+             */
+            struct Waiter {
+                coroutine_handle<> handle;
+                Executor* pExecutor;
+                int item; // put이면 저장할 값, get이면 받은 값
+                Waiter* pNext;
+            };
+
+            /**
+             * @brief Waiter의 intrusive FIFO 목록.
+             */
+            struct WaiterQueue {
+                Waiter* pHead = nullptr;
+                Waiter* pTail = nullptr;
+
+                bool isEmpty() const { return pHead == nullptr; }
+
+                void push(Waiter* pWaiter) {
+                    pWaiter->pNext = nullptr;
+                    if (pTail == nullptr)
+                        pHead = pWaiter;
+                    else
+                        pTail->pNext = pWaiter;
+                    pTail = pWaiter;
+                }
+
+                Waiter* pop() {
+                    Waiter* pWaiter = pHead;
+                    pHead = pWaiter->pNext;
+                    if (pHead == nullptr)
+                        pTail = nullptr;
+                    return pWaiter;
+                }
+            };
+
+            vector<int> _buffer;
+            const size_t BUFFER_SIZE;
+            size_t _front; // 지금까지 저장된 데이터 개수
+            size_t _back; // 지금까지 꺼낸 데이터 개수
+            mutex _mutex;
+            WaiterQueue _getWaiters; // 버퍼가 비어 있을 때만 존재한다.
+            WaiterQueue _putWaiters; // 버퍼가 가득 찼을 때만 존재한다.
+            condition_variable _notEmpty; // getFromNotEmptyBuffer로 기다리는 쓰레드
+            condition_variable _notFull; // putWithoutOverride로 기다리는 쓰레드
+
+            /**
+             * @brief item을 기다리는 consumer에게 넘기거나 버퍼에 저장한다. _mutex를 잡은 상태에서 호출해야 한다.
+             *
+             * @param pWoken 재개해야 할 consumer. 없으면 nullptr
+             *
+             * @return 저장했으면 true, 버퍼에 빈 공간이 없으면 false.
+             */
+            bool push(int item, Waiter*& pWoken) {
+
+                pWoken = nullptr;
+
+                if (!_getWaiters.isEmpty()) {
+                    pWoken = _getWaiters.pop();
+                    pWoken->item = item;
+                    return true;
+                }
+
+                if (_front - _back == BUFFER_SIZE)
+                    return false;
+
+                _buffer[_front % BUFFER_SIZE] = item;
+                ++_front;
+                _notEmpty.notify_one();
+
+                return true;
+            }
+
+            /**
+             * @brief 값을 꺼내고, 공간을 기다리던 producer가 있으면 그 값을 대신 저장한다.
+             * _mutex를 잡은 상태에서 호출해야 한다.
+             *
+             * @param pWoken 재개해야 할 producer. 없으면 nullptr
+             *
+             * @return 꺼냈으면 true, 버퍼가 비어 있으면 false.
+             */
+            bool pop(int& item, Waiter*& pWoken) {
+
+                pWoken = nullptr;
+
+                if (_front == _back)
+                    return false;
+
+                item = _buffer[_back % BUFFER_SIZE];
+                ++_back;
+
+                if (!_putWaiters.isEmpty()) {
+                    pWoken = _putWaiters.pop();
+                    _buffer[_front % BUFFER_SIZE] = pWoken->item;
+                    ++_front;
+                }
+                else {
+                    _notFull.notify_one();
+                }
+
+                return true;
+            }
+
+            /**
+             * @brief lock을 놓은 뒤 호출한다.
+             */
+            static void resume(Waiter* pWoken) {
+                if (pWoken != nullptr)
+                    pWoken->pExecutor->execute(pWoken->handle);
+            }
+
+        public:
+            /**
+             * @brief co_await asyncPut(item)의 awaiter.
+             */
+            class PutAwaiter {
+
+                private:
+                    AsyncRingBuffer& _ringBuffer;
+                    Waiter _waiter;
+
+                public:
+                    PutAwaiter(AsyncRingBuffer& ringBuffer, int item, Executor& executor):
+                        _ringBuffer(ringBuffer), _waiter{ nullptr, &executor, item, nullptr } {}
+
+                    bool await_ready() {
+                        return _ringBuffer.tryPut(_waiter.item);
+                    }
+
+                    bool await_suspend(coroutine_handle<> handle) {
+
+                        unique_lock<mutex> lock(_ringBuffer._mutex);
+
+                        /* Critical section start */
+                        // await_ready 이후에 공간이 생겼으면 멈추지 않는다.
+                        Waiter* pWoken;
+                        if (_ringBuffer.push(_waiter.item, pWoken)) {
+                            lock.unlock();
+                            resume(pWoken);
+                            return false;
+                        }
+
+                        _waiter.handle = handle;
+                        _ringBuffer._putWaiters.push(&_waiter);
+                        /* Critical section end */
+
+                        return true;
+                    }
+
+                    void await_resume() {}
+
+            }; // PutAwaiter
+
+
+            /**
+             * @brief co_await asyncGet()의 awaiter. 꺼낸 값을 반환한다.
+             */
+            class GetAwaiter {
+
+                private:
+                    AsyncRingBuffer& _ringBuffer;
+                    Waiter _waiter;
+
+                public:
+                    GetAwaiter(AsyncRingBuffer& ringBuffer, Executor& executor):
+                        _ringBuffer(ringBuffer), _waiter{ nullptr, &executor, 0, nullptr } {}
+
+                    bool await_ready() {
+                        return _ringBuffer.tryGet(_waiter.item);
+                    }
+
+                    bool await_suspend(coroutine_handle<> handle) {
+
+                        unique_lock<mutex> lock(_ringBuffer._mutex);
+
+                        /* Critical section start */
+                        Waiter* pWoken;
+                        if (_ringBuffer.pop(_waiter.item, pWoken)) {
+                            lock.unlock();
+                            resume(pWoken);
+                            return false;
+                        }
+
+                        _waiter.handle = handle;
+                        _ringBuffer._getWaiters.push(&_waiter);
+                        /* Critical section end */
+
+                        return true;
+                    }
+
+                    int await_resume() {
+                        return _waiter.item;
+                    }
+
+            }; // GetAwaiter
+
+
+            /**
+             * @brief Default Constructor which creates a buffer of length 10.
+             */
+            AsyncRingBuffer(): AsyncRingBuffer(10) {}
+
+            /**
+             * @brief Creates a ring buffer of length n.
+             *
+             * @param n Buffer size. 0이면 데이터를 넘겨줄 곳이 없어 멈춘 쪽이 깨어나지 못하므로 1로 만든다.
+             */
+            explicit AsyncRingBuffer(size_t n):
+                _buffer(n == 0 ? 1 : n), BUFFER_SIZE(n == 0 ? 1 : n), _front(0), _back(0) {}
+
+            AsyncRingBuffer(const AsyncRingBuffer&) = delete;
+            AsyncRingBuffer& operator=(const AsyncRingBuffer&) = delete;
+
+
+            /**
+             * @brief 빈 공간이 생길 때까지 coroutine을 멈춘 뒤 item을 저장한다.
+             *
+             * @param item 버퍼에 저장할 데이터.
+             * @param executor 멈췄던 경우 coroutine을 재개할 곳. co_await가 끝날 때까지 살아 있어야 한다.
+             */
+            PutAwaiter asyncPut (int item, Executor& executor) {
+                return PutAwaiter(*this, item, executor);
+            }
+
+            /**
+             * @brief 데이터가 저장될 때까지 coroutine을 멈춘 뒤 값을 꺼낸다.
+             *
+             * @param executor 멈췄던 경우 coroutine을 재개할 곳.
+             */
+            GetAwaiter asyncGet (Executor& executor) {
+                return GetAwaiter(*this, executor);
+            }
+
+
+            /**
+             * @brief put()과 같지만 저장 여부를 반환한다.
+             */
+            bool tryPut (int item) {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                Waiter* pWoken;
+                bool stored = push(item, pWoken);
+                /* Critical section end */
+
+                lock.unlock();
+                resume(pWoken);
+
+                return stored;
+            }
+
+            /**
+             * @brief get()과 같지만 버퍼가 비어 있으면 예외 대신 false를 반환한다.
+             */
+            bool tryGet (int& item) {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                Waiter* pWoken;
+                bool taken = pop(item, pWoken);
+                /* Critical section end */
+
+                lock.unlock();
+                resume(pWoken);
+
+                return taken;
+            }
+
+            /**
+             * @brief 버퍼에 빈 공간이 없으면 값을 쓰지 않는다.
+             */
+            void put (int item) {
+                tryPut(item);
+            }
+
+            /**
+             * @brief 데이터를 덮어쓰지 않고 빈 공간이 생길때까지 쓰레드가 대기한다.
+             */
+            void putWithoutOverride (int item) {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                Waiter* pWoken;
+                while (!push(item, pWoken))
+                    _notFull.wait(lock);
+                /* Critical section end */
+
+                lock.unlock();
+                resume(pWoken);
+            }
+
+            /**
+             * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 쓰레드가 대기한다.
+             */
+            int getFromNotEmptyBuffer () {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                int item;
+                Waiter* pWoken;
+                while (!pop(item, pWoken))
+                    _notEmpty.wait(lock);
+                /* Critical section end */
+
+                lock.unlock();
+                resume(pWoken);
+
+                return item;
+            }
+
+            /**
+             * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+             */
+            int get () {
+
+                int item;
+
+                if (!tryGet(item))
+                    throw EmptyBufferReadException();
+
+                return item;
+            }
+
+    }; // AsyncRingBuffer
+
+}; // rtos
+
+#endif // __has_include(<coroutine>)
+#endif // __cplusplus >= 202002L
+
+#endif // _ASYNC_RING_BUFFER_H_
@@ -0,0 +1,508 @@
+/**
+ * @file bench.cpp
+ * @brief Throughput and latency benchmark for ringbuffer variants.
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <pthread.h>
+
+#include "ringbuffer.h"
+#include "spscringbuffer.h"
+#include "mpmcringbuffer.h"
+#include "typedringbuffer.h"
+#include "shardedringbuffer.h"
+#include "latestvalue.h"
+
+
+using namespace rtos;
+using namespace std;
+
+
+/**
+ * @brief 벤치마크 변수
+ */
+namespace BENCH_PARAM {
+
+    const size_t CAPACITIES[] = { 16, 256, 4096 }; // 측정할 버퍼 크기
+    const size_t CAPACITY_NUM = sizeof(CAPACITIES) / sizeof(CAPACITIES[0]);
+    const size_t MANY = 4; // N:1, 1:N, N:M에서 사용할 쓰레드 개수
+
+    int ITEM_COUNT = 2000000; // 처리량 측정에서 주고 받을 데이터 개수 (argv[1]로 변경 가능)
+    const size_t BATCH_SIZE = 64; // putN/getN 한 번에 주고 받을 데이터 개수
+    const int ROUND_TRIPS = 100000; // 지연시간 측정에서 왕복할 횟수
+    const int WARMUP_ROUND_TRIPS = 1000;
+    const int WINDOW_REPEAT = 2000; // 최근 데이터 집계를 반복할 횟수
+
+}; // BENCH_PARAM
+
+
+/**
+ * @brief 현재 쓰레드를 core 번째 CPU에 고정한다. CPU 개수보다 큰 값은 나머지로 계산한다.
+ */
+void pinThread(size_t core) {
+
+    size_t cpus = max(1u, thread::hardware_concurrency());
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+
+/**
+ * @brief total을 n개로 나누었을 때 i번째 몫을 반환한다. 나머지는 앞쪽에 분배한다.
+ */
+int share(int total, size_t n, size_t i) {
+    return total / (int)n + ((int)i < total % (int)n ? 1 : 0);
+}
+
+
+/**
+ * @brief producer 번째 Producer 쓰레드의 put. ShardedRingBuffer는 Producer마다 다른 lane을 사용한다.
+ */
+template <typename Buffer>
+void producerPut(Buffer& buffer, size_t /*producer*/, int item) {
+    buffer.putWithoutOverride(item);
+}
+
+void producerPut(ShardedRingBuffer& buffer, size_t producer, int item) {
+    buffer.putWithoutOverride(producer, item);
+}
+
+
+/**
+ * @brief consumer 번째 Consumer 쓰레드의 get.
+ */
+template <typename Buffer>
+int consumerGet(Buffer& buffer, size_t /*consumer*/) {
+    return buffer.getFromNotEmptyBuffer();
+}
+
+int consumerGet(ShardedRingBuffer& buffer, size_t consumer) {
+    return buffer.getFromNotEmptyBuffer(consumer);
+}
+
+
+/**
+ * @brief pn개의 Producer와 cn개의 Consumer가 blocking put/get으로 ITEM_COUNT개의 데이터를 주고 받는다.
+ * 각 쓰레드는 서로 다른 core에 고정된다.
+ *
+ * @param buffer 측정할 버퍼
+ * @param pn Producer 쓰레드 개수
+ * @param cn Consumer 쓰레드 개수
+ *
+ * @return 초당 처리한 데이터 개수
+ */
+template <typename Buffer>
+double measureThroughput(Buffer& buffer, size_t pn, size_t cn) {
+
+    atomic<long long> sum(0);
+    atomic<size_t> ready(0);
+    atomic<bool> go(false);
+    vector<thread> threads;
+
+    for (size_t i=0; i<pn; i++) {
+        int count = share(BENCH_PARAM::ITEM_COUNT, pn, i);
+        threads.push_back(thread([&, i, count]() {
+            pinThread(i);
+            ready++;
+            while (!go.load())
+                this_thread::yield();
+            for (int j=0; j<count; ++j)
+                producerPut(buffer, i, j);
+        }));
+    }
+
+    for (size_t i=0; i<cn; i++) {
+        int count = share(BENCH_PARAM::ITEM_COUNT, cn, i);
+        threads.push_back(thread([&, i, count]() {
+            pinThread(pn + i);
+            ready++;
+            while (!go.load())
+                this_thread::yield();
+            long long local = 0;
+            for (int j=0; j<count; ++j)
+                local += consumerGet(buffer, i);
+            sum += local;
+        }));
+    }
+
+    // 모든 쓰레드가 준비된 뒤 동시에 시작한다.
+    while (ready.load() < pn + cn)
+        this_thread::yield();
+
+    auto start = chrono::steady_clock::now();
+    go.store(true);
+
+    for (size_t i=0; i<threads.size(); i++)
+        threads[i].join();
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    // 데이터가 모두 전달되었는지 확인한다.
+    long long expected = 0;
+    for (size_t i=0; i<pn; i++) {
+        long long count = share(BENCH_PARAM::ITEM_COUNT, pn, i);
+        expected += count * (count - 1) / 2;
+    }
+    if (sum != expected)
+        printf("checksum mismatch: %lld != %lld\n", sum.load(), expected);
+
+    return BENCH_PARAM::ITEM_COUNT / elapsed.count();
+}
+
+
+/**
+ * @brief Producer 하나와 Consumer 하나가 putN/getN으로 BATCH_SIZE개씩 데이터를 주고 받는다.
+ *
+ * @return 초당 처리한 데이터 개수
+ */
+double measureBatchThroughput(RingBuffer& buffer) {
+
+    auto start = chrono::steady_clock::now();
+
+    thread producer([&buffer]() {
+        pinThread(0);
+        int items[BENCH_PARAM::BATCH_SIZE];
+        int next = 0;
+        while (next < BENCH_PARAM::ITEM_COUNT) {
+            size_t n = min(BENCH_PARAM::BATCH_SIZE, (size_t)(BENCH_PARAM::ITEM_COUNT - next));
+            for (size_t i=0; i<n; ++i)
+                items[i] = next + (int)i;
+            // 일부만 저장된 경우 나머지를 다시 저장한다.
+            size_t stored = 0;
+            while (stored < n)
+                stored += buffer.putNWithoutOverride(items + stored, n - stored);
+            next += (int)n;
+        }
+    });
+
+    pinThread(1);
+
+    long long sum = 0;
+    int items[BENCH_PARAM::BATCH_SIZE];
+    int received = 0;
+    while (received < BENCH_PARAM::ITEM_COUNT) {
+        size_t n = buffer.getNFromNotEmptyBuffer(items, BENCH_PARAM::BATCH_SIZE);
+        for (size_t i=0; i<n; ++i)
+            sum += items[i];
+        received += (int)n;
+    }
+
+    producer.join();
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    long long expected = (long long)BENCH_PARAM::ITEM_COUNT * (BENCH_PARAM::ITEM_COUNT - 1) / 2;
+    if (sum != expected)
+        printf("checksum mismatch: %lld != %lld\n", sum, expected);
+
+    return BENCH_PARAM::ITEM_COUNT / elapsed.count();
+}
+
+
+/**
+ * @brief LatestValue로 전달하는 값. check는 항상 ~sequence이므로 찢어진 값을 찾을 수 있다.
+ */
+struct Sample {
+    long long sequence;
+    long long check;
+};
+
+
+/**
+ * @brief writer 하나가 LatestValue에 ITEM_COUNT번 저장하는 동안 reader MANY개가 readIfNewer로 계속 읽는다.
+ * reader는 값이 찢어지지 않았는지, version이 줄어들지 않는지 확인한다.
+ *
+ * @param reads reader들이 새 값을 읽은 총 횟수를 저장할 변수
+ *
+ * @return 초당 저장한 횟수
+ */
+double measureLatestValue(long long& reads) {
+
+    LatestValue<Sample> latest;
+    atomic<bool> done(false);
+    atomic<long long> totalReads(0);
+    atomic<int> errors(0);
+    vector<thread> readers;
+
+    for (size_t i=0; i<BENCH_PARAM::MANY; ++i) {
+        readers.push_back(thread([&, i]() {
+            pinThread(i + 1);
+            uint64_t lastSeen = 0;
+            long long local = 0;
+            Sample sample;
+            while (!done.load(memory_order_relaxed)) {
+                uint64_t previous = lastSeen;
+                if (!latest.readIfNewer(sample, lastSeen)) {
+                    this_thread::yield();
+                    continue;
+                }
+                if (sample.check != ~sample.sequence || lastSeen < previous || (uint64_t)sample.sequence != lastSeen)
+                    errors.fetch_add(1);
+                ++local;
+            }
+            totalReads += local;
+        }));
+    }
+
+    pinThread(0);
+    auto start = chrono::steady_clock::now();
+    for (long long i=1; i<=BENCH_PARAM::ITEM_COUNT; ++i) {
+        Sample sample = { i, ~i };
+        latest.store(sample);
+        // CPU가 하나인 경우에도 reader가 writer와 겹쳐 실행되도록 가끔 양보한다.
+        if (i % 1024 == 0)
+            this_thread::yield();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    done.store(true);
+    for (size_t i=0; i<readers.size(); ++i)
+        readers[i].join();
+
+    if (errors.load() > 0 || latest.version() != (uint64_t)BENCH_PARAM::ITEM_COUNT)
+        printf("LatestValue mismatch: %d torn or out-of-order reads\n", errors.load());
+
+    reads = totalReads.load();
+    return BENCH_PARAM::ITEM_COUNT / elapsed.count();
+}
+
+
+/**
+ * @brief 가득 찬 버퍼에서 aggregateWindow로 최근 capacity개를 반복해서 집계한다.
+ * 시작 위치를 가운데로 옮겨 두 구간으로 나뉘는 경우를 측정한다.
+ *
+ * @return 초당 집계한 데이터 개수
+ */
+double measureWindowAggregate(size_t capacity) {
+
+    RingBuffer buffer(capacity);
+    for (size_t i=0; i<capacity/2; ++i) {
+        buffer.put(0);
+        buffer.get();
+    }
+    for (size_t i=0; i<capacity; ++i)
+        buffer.put((int)i);
+
+    long long sum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i=0; i<BENCH_PARAM::WINDOW_REPEAT; ++i)
+        sum += buffer.aggregateWindow(capacity, (int)capacity / 2).sum;
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    long long expected = (long long)capacity * (capacity - 1) / 2 * BENCH_PARAM::WINDOW_REPEAT;
+    if (sum != expected)
+        printf("checksum mismatch: %lld != %lld\n", sum, expected);
+
+    return (double)capacity * BENCH_PARAM::WINDOW_REPEAT / elapsed.count();
+}
+
+
+/**
+ * @brief 두 버퍼로 ping-pong 하며 왕복 지연시간(ns)을 측정한다.
+ * echo 쓰레드는 request에서 꺼낸 값을 그대로 response에 저장한다.
+ *
+ * @param samples 측정한 왕복 지연시간이 정렬되어 저장될 벡터
+ */
+template <typename Buffer>
+void measureRoundTrip(Buffer& request, Buffer& response, vector<long long>& samples) {
+
+    thread echo([&request, &response]() {
+        pinThread(1);
+        while (true) {
+            int item = request.getFromNotEmptyBuffer();
+            response.putWithoutOverride(item);
+            if (item < 0)
+                break;
+        }
+    });
+
+    pinThread(0);
+    samples.clear();
+    samples.reserve(BENCH_PARAM::ROUND_TRIPS);
+
+    for (int i=0; i<BENCH_PARAM::WARMUP_ROUND_TRIPS + BENCH_PARAM::ROUND_TRIPS; ++i) {
+        auto start = chrono::steady_clock::now();
+        request.putWithoutOverride(i);
+        response.getFromNotEmptyBuffer();
+        auto end = chrono::steady_clock::now();
+        if (i >= BENCH_PARAM::WARMUP_ROUND_TRIPS)
+            samples.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+
+    request.putWithoutOverride(-1);
+    response.getFromNotEmptyBuffer();
+    echo.join();
+
+    sort(samples.begin(), samples.end());
+}
+
+
+/**
+ * @brief 정렬된 표본에서 백분위수를 구한다.
+ */
+long long percentile(const vector<long long>& sorted, double p) {
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1));
+    return sorted[index];
+}
+
+
+/**
+ * @brief 왕복 지연시간의 백분위수와 2의 거듭제곱 단위 histogram을 출력한다.
+ */
+void printLatency(const char* name, const vector<long long>& sorted) {
+
+    printf("%-16s p50 %7lldns  p99 %7lldns  p99.9 %7lldns  max %9lldns\n",
+        name,
+        percentile(sorted, 50.0),
+        percentile(sorted, 99.0),
+        percentile(sorted, 99.9),
+        sorted.back());
+
+    size_t bucket[64] = { 0 };
+    for (size_t i=0; i<sorted.size(); ++i) {
+        unsigned long long ns = (unsigned long long)max(sorted[i], 1LL);
+        bucket[63 - __builtin_clzll(ns)]++;
+    }
+    for (size_t b=0; b<64; ++b) {
+        if (bucket[b] == 0)
+            continue;
+        printf("    < %9lluns %7.3f%%\n", 2ULL << b, 100.0 * bucket[b] / sorted.size());
+    }
+}
+
+
+/**
+ * @brief 한 종류의 버퍼에 대해 1:1, N:1, 1:N, N:M 처리량을 한 줄로 출력한다.
+ */
+template <typename Buffer>
+void printThroughputRow(const char* name, size_t capacity) {
+
+    const size_t n = BENCH_PARAM::MANY;
+
+    Buffer oneToOne(capacity);
+    Buffer manyToOne(capacity);
+    Buffer oneToMany(capacity);
+    Buffer manyToMany(capacity);
+
+    printf("%-16s %6zu %12.0f %12.0f %12.0f %12.0f\n",
+        name,
+        capacity,
+        measureThroughput(oneToOne, 1, 1),
+        measureThroughput(manyToOne, n, 1),
+        measureThroughput(oneToMany, 1, n),
+        measureThroughput(manyToMany, n, n));
+}
+
+
+/**
+ * @brief ShardedRingBuffer의 처리량. lane은 Producer마다 하나이고 lane 하나의 크기가 capacity이다.
+ */
+void printShardedThroughputRow(const char* name, size_t capacity, bool isFifo) {
+
+    const size_t n = BENCH_PARAM::MANY;
+
+    ShardedRingBuffer oneToOne(1, capacity, 1, isFifo);
+    ShardedRingBuffer manyToOne(n, capacity, 1, isFifo);
+    ShardedRingBuffer manyToMany(n, capacity, n, isFifo);
+
+    printf("%-16s %6zu %12.0f %12.0f ", name, capacity,
+        measureThroughput(oneToOne, 1, 1), measureThroughput(manyToOne, n, 1));
+
+    // FIFO이면 home lane이 없는 consumer가 생기므로 lane 1개, consumer N개로 만들 수 없다.
+    if (isFifo)
+        printf("%12s ", "n/a");
+    else {
+        ShardedRingBuffer oneToMany(1, capacity, n, isFifo);
+        printf("%12.0f ", measureThroughput(oneToMany, 1, n));
+    }
+
+    printf("%12.0f\n", measureThroughput(manyToMany, n, n));
+}
+
+
+int main(int argc, char* argv[]) {
+
+    if (argc > 1)
+        BENCH_PARAM::ITEM_COUNT = atoi(argv[1]);
+
+    printf("items: %d, cpus: %u\n\n", BENCH_PARAM::ITEM_COUNT, thread::hardware_concurrency());
+
+    // 처리량 (ops/s)
+    printf("%-16s %6s %12s %12s %12s %12s\n", "buffer", "size",
+        "1:1", "N:1", "1:N", "N:M");
+    for (size_t i=0; i<BENCH_PARAM::CAPACITY_NUM; ++i) {
+        size_t capacity = BENCH_PARAM::CAPACITIES[i];
+        printThroughputRow<RingBuffer>("RingBuffer", capacity);
+        printThroughputRow<MpmcRingBuffer>("MpmcRingBuffer", capacity);
+        printThroughputRow<TypedRingBuffer<int> >("TypedRingBuffer", capacity);
+        printShardedThroughputRow("Sharded", capacity, false);
+        printShardedThroughputRow("Sharded(FIFO)", capacity, true);
+
+        SpscRingBuffer spscBuffer(capacity);
+        RingBuffer batchBuffer(capacity);
+        printf("%-16s %6zu %12.0f\n", "SpscRingBuffer", capacity, measureThroughput(spscBuffer, 1, 1));
+        printf("%-16s %6zu %12.0f\n", "RingBuffer(N)", capacity, measureBatchThroughput(batchBuffer));
+    }
+    printf("(N = M = %zu)\n\n", BENCH_PARAM::MANY);
+
+    // 최근 데이터 집계 (items/s)
+    printf("%-16s %6s %12s\n", "window", "size", windowKernelName());
+    for (size_t i=0; i<BENCH_PARAM::CAPACITY_NUM; ++i) {
+        size_t capacity = BENCH_PARAM::CAPACITIES[i];
+        printf("%-16s %6zu %12.0f\n", "aggregateWindow", capacity, measureWindowAggregate(capacity));
+    }
+    printf("\n");
+
+    // 최신 값 전달 (writer 1, reader N)
+    {
+        long long reads;
+        double stores = measureLatestValue(reads);
+        printf("%-16s %12s %12s\n", "latest", "stores/s", "new reads");
+        printf("%-16s %12.0f %12lld\n\n", "LatestValue", stores, reads);
+    }
+
+    // 왕복 지연시간
+    vector<long long> samples;
+    {
+        RingBuffer request(BENCH_PARAM::CAPACITIES[0]), response(BENCH_PARAM::CAPACITIES[0]);
+        measureRoundTrip(request, response, samples);
+        printLatency("RingBuffer", samples);
+    }
+    {
+        // BUSY_SPIN은 CPU가 하나이면 매 왕복마다 time slice가 끝나기를 기다리므로 제외한다.
+        const WaitStrategy strategies[] = {
+            WaitStrategy::SPIN_YIELD, WaitStrategy::SPIN_PARK, WaitStrategy::BUSY_SPIN };
+        const char* names[] = { "  SPIN_YIELD", "  SPIN_PARK", "  BUSY_SPIN" };
+        size_t count = thread::hardware_concurrency() > 1 ? 3 : 2;
+        for (size_t i=0; i<count; ++i) {
+            RingBuffer request(BENCH_PARAM::CAPACITIES[0], strategies[i]);
+            RingBuffer response(BENCH_PARAM::CAPACITIES[0], strategies[i]);
+            measureRoundTrip(request, response, samples);
+            printLatency(names[i], samples);
+        }
+    }
+    {
+        SpscRingBuffer request(BENCH_PARAM::CAPACITIES[0]), response(BENCH_PARAM::CAPACITIES[0]);
+        measureRoundTrip(request, response, samples);
+        printLatency("SpscRingBuffer", samples);
+    }
+    {
+        MpmcRingBuffer request(BENCH_PARAM::CAPACITIES[0]), response(BENCH_PARAM::CAPACITIES[0]);
+        measureRoundTrip(request, response, samples);
+        printLatency("MpmcRingBuffer", samples);
+    }
+
+    return 0;
+}
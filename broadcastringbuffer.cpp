@@ -0,0 +1,266 @@
+/**
+ * @file broadcastringbuffer.cpp
+ * @brief Multicast RingBuffer in which every consumer sees every item
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <new>
+#include <thread>
+
+#include "broadcastringbuffer.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief Creates a ring buffer of length n shared by the given number of consumers.
+     *
+     * @param n Buffer size.
+     * @param consumers consumer 개수. consumer는 0부터 consumers - 1까지의 번호를 사용한다.
+     * @param policy 가장 느린 consumer가 한 바퀴 뒤처졌을 때의 처리 방법
+     */
+    BroadcastRingBuffer::BroadcastRingBuffer(size_t n, size_t consumers, SlowConsumerPolicy policy):
+        BUFFER_SIZE(n), CONSUMER_NUM(consumers), _cursorStorage(consumers * sizeof(Cursor), StorageOptions()),
+        _policy(policy) {
+
+        _pBuffer = new Slot[BUFFER_SIZE];
+        for (size_t i=0; i<BUFFER_SIZE; ++i) {
+            _pBuffer[i].sequence.store(0, memory_order_relaxed);
+            _pBuffer[i].data.store(0, memory_order_relaxed);
+        }
+
+        _pCursors = static_cast<Cursor*>(_cursorStorage.data());
+        for (size_t i=0; i<CONSUMER_NUM; ++i) {
+            new (&_pCursors[i]) Cursor();
+            _pCursors[i].position.store(0, memory_order_relaxed);
+            _pCursors[i].isActive.store(true, memory_order_relaxed);
+        }
+
+        _next.store(0, memory_order_relaxed);
+        _gate.store(0, memory_order_relaxed);
+    }
+
+
+    BroadcastRingBuffer::~BroadcastRingBuffer() {
+        delete [] _pBuffer;
+    }
+
+
+    /**
+     * @brief 제외되지 않은 consumer 중 가장 느린 cursor의 위치. 모두 제외되었으면 pos.
+     */
+    size_t BroadcastRingBuffer::slowestCursor(size_t pos) noexcept {
+
+        size_t slowest = pos;
+        bool found = false;
+
+        for (size_t i=0; i<CONSUMER_NUM; ++i) {
+            if (!_pCursors[i].isActive.load(memory_order_acquire))
+                continue;
+            size_t position = _pCursors[i].position.load(memory_order_acquire);
+            if (!found || position < slowest) {
+                slowest = position;
+                found = true;
+            }
+        }
+
+        return slowest;
+    }
+
+
+    /**
+     * @brief pos에 쓰더라도 아직 읽지 않은 데이터를 덮어쓰지 않는지 확인한다.
+     * 사본(_gate)으로 충분하지 않을 때만 모든 cursor를 다시 읽는다.
+     */
+    bool BroadcastRingBuffer::hasRoom(size_t pos) noexcept {
+
+        if (_gate.load(memory_order_relaxed) + BUFFER_SIZE > pos)
+            return true;
+
+        size_t gate = slowestCursor(pos);
+        _gate.store(gate, memory_order_relaxed);
+
+        return gate + BUFFER_SIZE > pos;
+    }
+
+
+    /**
+     * @brief pos에 쓰면 읽지 못한 데이터를 잃게 되는 consumer를 제외한다.
+     */
+    void BroadcastRingBuffer::dropSlowConsumers(size_t pos) noexcept {
+
+        if (hasRoom(pos))
+            return;
+
+        for (size_t i=0; i<CONSUMER_NUM; ++i) {
+            if (_pCursors[i].position.load(memory_order_acquire) + BUFFER_SIZE <= pos)
+                _pCursors[i].isActive.store(false, memory_order_release);
+        }
+    }
+
+
+    /**
+     * @brief 차지한 위치 pos에 item을 쓰고 consumer에게 공개한다.
+     */
+    void BroadcastRingBuffer::publish(size_t pos, int item) noexcept {
+
+        if (_policy == SlowConsumerPolicy::DROP)
+            dropSlowConsumers(pos);
+
+        Slot& slot = _pBuffer[pos % BUFFER_SIZE];
+
+        // 같은 slot의 이전 바퀴를 쓰는 producer가 끝날 때까지 기다린다.
+        if (pos >= BUFFER_SIZE) {
+            while (slot.sequence.load(memory_order_acquire) != pos + 1 - BUFFER_SIZE)
+                this_thread::yield();
+        }
+
+        slot.sequence.store(0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.data.store(item, memory_order_relaxed);
+        slot.sequence.store(pos + 1, memory_order_release);
+    }
+
+
+    /**
+     * @brief consumer의 cursor 위치에 있는 데이터를 읽고 cursor를 옮긴다.
+     *
+     * @return READY: 읽었다. EMPTY: 아직 저장되지 않았다. DROPPED: 제외되었다.
+     */
+    BroadcastRingBuffer::ReadResult BroadcastRingBuffer::read(size_t consumer, int& item) noexcept {
+
+        Cursor& cursor = _pCursors[consumer];
+
+        if (!cursor.isActive.load(memory_order_acquire))
+            return ReadResult::DROPPED;
+
+        size_t pos = cursor.position.load(memory_order_relaxed);
+        Slot& slot = _pBuffer[pos % BUFFER_SIZE];
+
+        size_t seq = slot.sequence.load(memory_order_acquire);
+        int data = slot.data.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+
+        if (seq != pos + 1 || slot.sequence.load(memory_order_relaxed) != seq) {
+            // 다음 바퀴의 데이터로 덮어써졌으면 이미 제외된 것이다.
+            if (seq > pos + 1) {
+                cursor.isActive.store(false, memory_order_release);
+                return ReadResult::DROPPED;
+            }
+            return ReadResult::EMPTY;
+        }
+
+        item = data;
+        cursor.position.store(pos + 1, memory_order_release);
+
+        return ReadResult::READY;
+    }
+
+
+    /**
+     * @brief 가장 느린 consumer가 한 바퀴 뒤처져 있으면 값을 쓰지 않는다.
+     * DROP 정책에서는 뒤처진 consumer를 제외하고 저장한다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void BroadcastRingBuffer::put(int item) noexcept {
+
+        size_t pos = _next.load(memory_order_relaxed);
+
+        do {
+            if (_policy == SlowConsumerPolicy::BLOCK && !hasRoom(pos))
+                return;
+        } while (!_next.compare_exchange_weak(pos, pos + 1, memory_order_acq_rel));
+
+        publish(pos, item);
+    }
+
+
+    /**
+     * @brief 가장 느린 consumer가 읽을 때까지 기다린 뒤 저장한다. DROP 정책에서는 put과 같다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void BroadcastRingBuffer::putWithoutOverride(int item) noexcept {
+
+        size_t pos = _next.fetch_add(1, memory_order_acq_rel);
+
+        if (_policy == SlowConsumerPolicy::BLOCK) {
+            while (!hasRoom(pos))
+                this_thread::yield();
+        }
+
+        publish(pos, item);
+    }
+
+
+    /**
+     * @brief consumer가 아직 읽지 않은 가장 오래된 값을 읽는다. 다른 consumer는 같은 값을 따로 읽는다.
+     * 새로운 값이 없으면 EmptyBufferReadException, 제외되었으면 ConsumerDroppedException을 던진다.
+     *
+     * @param consumer consumer 번호
+     *
+     * @return 버퍼의 데이터.
+     */
+    int BroadcastRingBuffer::get(size_t consumer) {
+
+        int item;
+
+        switch (read(consumer, item)) {
+            case ReadResult::READY:
+                return item;
+            case ReadResult::EMPTY:
+                throw EmptyBufferReadException();
+            default:
+                throw ConsumerDroppedException();
+        }
+    }
+
+
+    /**
+     * @brief 새로운 값이 저장될 때까지 기다린다. 제외되면 ConsumerDroppedException을 던진다.
+     *
+     * @param consumer consumer 번호
+     *
+     * @return 버퍼의 데이터.
+     */
+    int BroadcastRingBuffer::getFromNotEmptyBuffer(size_t consumer) {
+
+        int item;
+
+        while (true) {
+            ReadResult result = read(consumer, item);
+            if (result == ReadResult::READY)
+                return item;
+            if (result == ReadResult::DROPPED)
+                throw ConsumerDroppedException();
+            this_thread::yield();
+        }
+    }
+
+
+    /**
+     * @brief DROP 정책에 의해 제외되었는지 확인한다.
+     */
+    bool BroadcastRingBuffer::isDropped(size_t consumer) const noexcept {
+        return !_pCursors[consumer].isActive.load(memory_order_acquire);
+    }
+
+
+    /**
+     * @brief 제외된 consumer를 다시 참여시킨다. 놓친 데이터는 건너뛰고 이후에 저장되는 값부터 읽는다.
+     *
+     * @param consumer consumer 번호
+     */
+    void BroadcastRingBuffer::rejoin(size_t consumer) noexcept {
+
+        Cursor& cursor = _pCursors[consumer];
+
+        cursor.position.store(_next.load(memory_order_acquire), memory_order_relaxed);
+        cursor.isActive.store(true, memory_order_release);
+    }
+
+}; // rtos
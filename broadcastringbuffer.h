@@ -0,0 +1,107 @@
+/**
+ * @file broadcastringbuffer.h
+ * @brief Multicast RingBuffer in which every consumer sees every item
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _BROADCAST_RING_BUFFER_H_
+#define _BROADCAST_RING_BUFFER_H_
+
+#include <cstddef>
+#include <string>
+#include <atomic>
+#include <exception>
+
+#include "ringbuffer.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 가장 느린 consumer가 producer를 따라오지 못할 때의 처리 방법.
+     */
+    enum class SlowConsumerPolicy {
+        BLOCK, // producer가 기다린다. put은 저장하지 않는다. (기본값)
+        DROP,  // 한 바퀴 뒤처진 consumer를 제외하고 계속 쓴다.
+    };
+
+
+    /**
+     * @brief 모든 consumer가 모든 데이터를 읽는 RingBuffer. (fan-out)
+     *
+     * consumer마다 자신이 다음에 읽을 위치(cursor)를 가지며, get은 자신의 cursor만 옮기므로
+     * 다른 consumer에게 영향을 주지 않는다. producer는 가장 느린 consumer보다 한 바퀴 이상 앞설 수 없다.
+     * 여러 producer가 동시에 저장할 수 있으며, 위치는 CAS로 차지한다.
+     *
+     * 각 slot은 sequence 번호(pos + 1, 쓰는 중에는 0)를 가진다.
+     * DROP 정책에서는 뒤처진 consumer를 제외한 뒤 덮어쓰므로, 제외된 consumer가 읽는 중이던
+     * 데이터는 sequence 번호로 걸러지고 이후의 get은 ConsumerDroppedException을 던진다.
+     */
+    class BroadcastRingBuffer {
+
+        private:
+            struct Slot {
+                atomic<size_t> sequence; // 발행된 위치 + 1. 0이면 쓰는 중이다.
+                atomic<int> data;
+            };
+
+            struct alignas(CACHE_LINE_SIZE) Cursor {
+                atomic<size_t> position; // 다음에 읽을 위치. 해당 consumer만 갱신한다.
+                atomic<bool> isActive; // DROP 정책에서 제외되면 false
+            };
+
+            enum class ReadResult { READY, EMPTY, DROPPED };
+
+            Slot* _pBuffer;
+            const size_t BUFFER_SIZE;
+            const size_t CONSUMER_NUM;
+            // C++11의 new는 alignas(CACHE_LINE_SIZE)를 보장하지 않으므로 정렬된 저장 공간에 직접 생성한다.
+            SlotStorage _cursorStorage;
+            Cursor* _pCursors;
+            const SlowConsumerPolicy _policy;
+
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _next; // 다음에 차지할 위치
+            atomic<size_t> _gate; // 마지막으로 계산한 가장 느린 cursor의 위치 (producer용 사본)
+
+            size_t slowestCursor(size_t pos) noexcept;
+            bool hasRoom(size_t pos) noexcept;
+            void dropSlowConsumers(size_t pos) noexcept;
+            void publish(size_t pos, int item) noexcept;
+            ReadResult read(size_t consumer, int& item) noexcept;
+
+        public:
+            BroadcastRingBuffer(size_t n, size_t consumers, SlowConsumerPolicy policy = SlowConsumerPolicy::BLOCK);
+            ~BroadcastRingBuffer();
+
+            BroadcastRingBuffer(const BroadcastRingBuffer&) = delete;
+            BroadcastRingBuffer& operator=(const BroadcastRingBuffer&) = delete;
+
+            void put (int item) noexcept;
+            void putWithoutOverride (int item) noexcept;
+            int get (size_t consumer);
+            int getFromNotEmptyBuffer (size_t consumer);
+
+            bool isDropped (size_t consumer) const noexcept;
+            void rejoin (size_t consumer) noexcept;
+
+    }; // BroadcastRingBuffer
+
+
+    class ConsumerDroppedException : public exception {
+
+        private:
+            const string _message = "Consumer fell a full buffer behind and was dropped";
+
+        public:
+            const char* what() const throw() {
+                return _message.c_str();
+            }
+
+    }; // ConsumerDroppedException
+
+}; // rtos
+
+#endif // _BROADCAST_RING_BUFFER_H_
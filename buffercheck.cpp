@@ -0,0 +1,670 @@
+/**
+ * @file buffercheck.cpp
+ * @brief Deterministic single-thread checks of every buffer's wraparound, full/empty and ordering behaviour
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <exception>
+
+#include "ringbuffer.h"
+#include "spscringbuffer.h"
+#include "mpmcringbuffer.h"
+#include "overwriteringbuffer.h"
+#include "shmringbuffer.h"
+#include "recordringbuffer.h"
+#include "shardedringbuffer.h"
+#include "broadcastringbuffer.h"
+#include "priorityringbuffer.h"
+#include "elasticringbuffer.h"
+#include "spillringbuffer.h"
+#include "latestvalue.h"
+
+// kernel들은 windowaggregate.cpp 안의 static 함수이므로 같은 번역 단위에 포함하여 직접 비교한다.
+// 그래서 windowaggregate.cpp는 따로 link하지 않는다.
+#include "windowaggregate.cpp"
+
+
+using namespace rtos;
+using namespace std;
+
+
+/**
+ * @brief 확인 변수
+ */
+namespace CHECK_PARAM {
+
+    const size_t BUFFER_SIZE = 4;
+    const size_t ROUNDS = 5; // 끝에서 처음으로 넘어가도록 버퍼를 여러 바퀴 돌린다.
+    const size_t WINDOW_LENGTH = 100; // kernel을 비교할 최대 길이
+    const unsigned SEED = 2023;
+    const char* SPILL_DIRECTORY = "/tmp";
+    const char* SHM_NAME = "rtos_buffercheck";
+
+}; // CHECK_PARAM
+
+
+/**
+ * @brief 조건이 거짓이면 오류 개수를 늘린다.
+ */
+void expect(bool condition, int& errors) {
+    if (!condition)
+        ++errors;
+}
+
+
+/**
+ * @brief call이 Exception을 던지면 true.
+ */
+template <typename Exception, typename Call>
+bool throws(Call call) {
+    try {
+        call();
+    }
+    catch (const Exception&) {
+        return true;
+    }
+    catch (...) {
+        return false;
+    }
+    return false;
+}
+
+
+/**
+ * @brief 4개의 기본 함수를 가진 버퍼를 여러 바퀴 채우고 비우며 순서, 가득 찬 경우, 빈 경우를 확인한다.
+ * put은 가득 차면 저장하지 않고, get은 비어 있으면 EmptyBufferReadException을 던져야 한다.
+ */
+template <typename Buffer>
+int checkFifo(Buffer& buffer, size_t capacity) {
+
+    int errors = 0;
+    int next = 0;
+
+    for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+        for (size_t i=0; i<capacity; ++i)
+            buffer.putWithoutOverride(next + (int)i);
+        buffer.put(-1); // 가득 찼으므로 버려진다.
+
+        for (size_t i=0; i<capacity; ++i)
+            expect(buffer.get() == next + (int)i, errors);
+        expect(throws<EmptyBufferReadException>([&]() { buffer.get(); }), errors);
+
+        next += (int)capacity;
+    }
+
+    // 절반씩 채우고 비우면 읽고 쓰는 위치가 버퍼 중간에서 끝을 넘어간다.
+    for (size_t round=0; round<CHECK_PARAM::ROUNDS * 2; ++round) {
+        for (size_t i=0; i<capacity / 2 + 1; ++i)
+            buffer.put(next + (int)i);
+        for (size_t i=0; i<capacity / 2 + 1; ++i)
+            expect(buffer.getFromNotEmptyBuffer() == next + (int)i, errors);
+        next += (int)(capacity / 2 + 1);
+    }
+
+    return errors;
+}
+
+
+/**
+ * @brief 결과를 출력하고 실패 여부를 반환한다.
+ */
+bool report(const char* name, int errors) {
+    bool isFailed = errors != 0;
+    printf("%-28s errors %d: %s\n", name, errors, isFailed ? "FAIL" : "ok");
+    return isFailed;
+}
+
+
+/**
+ * @brief 한 칸씩 집계하는 기준 결과와 모든 field가 같으면 true.
+ */
+bool isSameAggregate(const WindowAggregate& a, const WindowAggregate& b) {
+    return a.count == b.count && a.sum == b.sum && a.min == b.min && a.max == b.max
+        && a.aboveThreshold == b.aboveThreshold && a.crossings == b.crossings && a.isAbove == b.isAbove;
+}
+
+
+int checkRingBuffer() {
+
+    int errors = 0;
+    RingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+    errors += checkFifo(buffer, CHECK_PARAM::BUFFER_SIZE);
+
+    // batch 함수는 끝을 넘는 구간도 순서대로 복사해야 한다.
+    int items[CHECK_PARAM::BUFFER_SIZE + 1] = { 10, 11, 12, 13, 14 };
+    int out[CHECK_PARAM::BUFFER_SIZE + 1] = {};
+    buffer.put(0);
+    buffer.get(); // 읽고 쓰는 위치를 한 칸 옮긴다. checkFifo 뒤의 위치는 2이므로 3부터 쓴다.
+    expect(buffer.putN(items, CHECK_PARAM::BUFFER_SIZE + 1) == CHECK_PARAM::BUFFER_SIZE, errors);
+    expect(buffer.getN(out, CHECK_PARAM::BUFFER_SIZE + 1) == CHECK_PARAM::BUFFER_SIZE, errors);
+    expect(memcmp(items, out, CHECK_PARAM::BUFFER_SIZE * sizeof(int)) == 0, errors);
+    expect(buffer.getN(out, 1) == 0, errors);
+
+    // 끝을 넘어가는 최근 구간의 집계는 같은 데이터를 한 칸씩 집계한 결과와 같아야 한다.
+    RingBuffer window(CHECK_PARAM::BUFFER_SIZE);
+    window.put(0);
+    window.get(); // 가장 최근 구간이 끝에서 처음으로 넘어가도록 위치를 옮긴다.
+    int recent[] = { -4, -1, 2, 5 };
+    for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE; ++i)
+        window.put(recent[i]);
+    size_t visits = 0;
+    window.visitWindow(CHECK_PARAM::BUFFER_SIZE, [&](const int*, size_t) { ++visits; });
+    expect(visits == 2, errors);
+
+    WindowAggregate expected = emptyWindowAggregate();
+    accumulateScalar(recent, CHECK_PARAM::BUFFER_SIZE, 0, expected);
+    expect(isSameAggregate(window.aggregateWindow(CHECK_PARAM::BUFFER_SIZE, 0), expected), errors);
+
+    return errors;
+}
+
+
+int checkSpsc() {
+
+    int errors = 0;
+    SpscRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+    errors += checkFifo(buffer, CHECK_PARAM::BUFFER_SIZE);
+
+    // reserve/peek은 끝에서 처음으로 넘어가는 부분을 포함하지 않는다.
+    SpscRingBuffer region(CHECK_PARAM::BUFFER_SIZE);
+    for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE - 1; ++i)
+        region.put((int)i);
+    for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE - 1; ++i)
+        region.get(); // 마지막 slot부터 쓰도록 위치를 옮긴다.
+
+    int* pRegion;
+    size_t length = region.reserve(pRegion);
+    expect(length == 1, errors);
+    pRegion[0] = 100;
+    region.commit(1);
+    length = region.reserve(pRegion);
+    expect(length == CHECK_PARAM::BUFFER_SIZE - 1, errors);
+    for (size_t i=0; i<length; ++i)
+        pRegion[i] = 101 + (int)i;
+    region.commit(length);
+    expect(region.reserve(pRegion) == 0, errors);
+
+    const int* data;
+    length = region.peek(data);
+    expect(length == 1 && data[0] == 100, errors);
+    region.release(length);
+    length = region.peek(data);
+    expect(length == CHECK_PARAM::BUFFER_SIZE - 1 && data[0] == 101 && data[length - 1] == 100 + (int)length, errors);
+    region.release(length);
+    expect(region.peek(data) == 0, errors);
+
+    return errors;
+}
+
+
+int checkMpmc() {
+
+    int errors = 0;
+    MpmcRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+    errors += checkFifo(buffer, CHECK_PARAM::BUFFER_SIZE);
+
+    int item;
+    expect(!buffer.tryGet(item), errors);
+
+    // 크기가 MPMC_MIN_BUFFER_SIZE보다 작으면 MPMC_MIN_BUFFER_SIZE로 만든다.
+    MpmcRingBuffer small(1);
+    for (size_t i=0; i<MPMC_MIN_BUFFER_SIZE; ++i)
+        expect(small.tryPut((int)i), errors);
+    expect(!small.tryPut(-1), errors);
+    for (size_t i=0; i<MPMC_MIN_BUFFER_SIZE; ++i)
+        expect(small.tryGet(item) && item == (int)i, errors);
+    errors += checkFifo(small, MPMC_MIN_BUFFER_SIZE);
+
+    return errors;
+}
+
+
+int checkOverwrite() {
+
+    int errors = 0;
+    OverwriteRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE);
+    size_t missed;
+    int next = 0;
+
+    for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+        // 두 바퀴 넘게 저장하면 가장 최근 BUFFER_SIZE개만 남고 나머지는 missed로 보고된다.
+        const size_t stored = CHECK_PARAM::BUFFER_SIZE * 2 + 1;
+        for (size_t i=0; i<stored; ++i)
+            buffer.put(next + (int)i);
+
+        expect(buffer.get(missed) == next + (int)(stored - CHECK_PARAM::BUFFER_SIZE), errors);
+        expect(missed == stored - CHECK_PARAM::BUFFER_SIZE, errors);
+        for (size_t i=stored - CHECK_PARAM::BUFFER_SIZE + 1; i<stored; ++i) {
+            expect(buffer.get(missed) == next + (int)i, errors);
+            expect(missed == 0, errors);
+        }
+        expect(throws<EmptyBufferReadException>([&]() { buffer.get(); }), errors);
+
+        next += (int)stored;
+    }
+    expect(buffer.missed() == CHECK_PARAM::ROUNDS * (CHECK_PARAM::BUFFER_SIZE + 1), errors);
+
+    return errors;
+}
+
+
+int checkShm() {
+
+    int errors = 0;
+
+    ShmRingBuffer::remove(CHECK_PARAM::SHM_NAME);
+    ShmRingBuffer owner(CHECK_PARAM::SHM_NAME, CHECK_PARAM::BUFFER_SIZE);
+    errors += checkFifo(owner, CHECK_PARAM::BUFFER_SIZE);
+
+    // 연결한 쪽은 같은 header와 slot을 본다.
+    ShmRingBuffer peer(CHECK_PARAM::SHM_NAME);
+    owner.put(7);
+    expect(peer.get() == 7, errors);
+    expect(!owner.hasDeadPeer(), errors);
+    peer.detach();
+    expect(!peer.isAttached(), errors);
+
+    expect(throws<SharedMemoryException>([]() { ShmRingBuffer empty("rtos_buffercheck_zero", 0); }), errors);
+
+    return errors;
+}
+
+
+int checkRecord() {
+
+    int errors = 0;
+    RecordRingBuffer buffer(1);
+    const size_t capacity = buffer.capacity();
+    vector<char> record(capacity);
+    vector<char> out(capacity);
+
+    // 길이가 다른 record를 여러 바퀴 저장하면 일부는 버퍼 끝에 걸친다.
+    size_t stored = 0;
+    for (size_t length=1; stored < capacity * CHECK_PARAM::ROUNDS; length = length * 7 % 251 + 1) {
+        for (size_t i=0; i<length; ++i)
+            record[i] = (char)(length + i);
+        expect(buffer.put(record.data(), length), errors);
+
+        const void* p;
+        size_t peeked;
+        if (length % 2 == 0) {
+            p = buffer.peek(peeked);
+            expect(p != nullptr && peeked == length && memcmp(p, record.data(), length) == 0, errors);
+            buffer.release();
+        }
+        else {
+            expect(buffer.get(out.data(), out.size()) == length, errors);
+            expect(memcmp(out.data(), record.data(), length) == 0, errors);
+        }
+        stored += length;
+    }
+
+    size_t peeked;
+    expect(buffer.peek(peeked) == nullptr, errors);
+    expect(throws<EmptyBufferReadException>([&]() { buffer.get(out.data(), out.size()); }), errors);
+
+    // header(4 byte)가 들어갈 공간이 없는 record는 저장할 수 없다.
+    expect(!buffer.put(record.data(), capacity), errors);
+    expect(!buffer.putWithoutOverride(record.data(), capacity), errors);
+    expect(!buffer.put(record.data(), (size_t)UINT32_MAX + 1), errors);
+
+    // 가득 차면 put은 record를 버린다.
+    size_t records = 0;
+    while (buffer.put(record.data(), 60))
+        ++records;
+    expect(records == capacity / 64, errors);
+    for (size_t i=0; i<records; ++i)
+        expect(buffer.getFromNotEmptyBuffer(out.data(), out.size()) == 60, errors);
+
+    return errors;
+}
+
+
+int checkSharded() {
+
+    int errors = 0;
+    int item;
+
+    // FIFO이면 consumer c는 lane % 2 == c인 lane만 꺼내고, lane마다 저장한 순서를 지킨다.
+    {
+        const size_t lanes = 4, consumers = 2, perLane = 3;
+        ShardedRingBuffer buffer(lanes, CHECK_PARAM::BUFFER_SIZE, consumers, true);
+
+        for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+            for (size_t i=0; i<perLane; ++i)
+                for (size_t lane=0; lane<lanes; ++lane)
+                    buffer.putWithoutOverride(lane, (int)(lane * 100 + round * perLane + i));
+
+            for (size_t consumer=0; consumer<consumers; ++consumer) {
+                size_t last[lanes] = {};
+                size_t received = 0;
+                while (buffer.tryGet(consumer, item)) {
+                    size_t lane = item / 100;
+                    size_t seq = item % 100 + 1;
+                    expect(lane % consumers == consumer, errors);
+                    expect(seq > last[lane], errors);
+                    last[lane] = seq;
+                    ++received;
+                }
+                expect(received == perLane * lanes / consumers, errors);
+            }
+        }
+    }
+
+    // FIFO가 아니면 home lane이 비었을 때 다른 lane에서 훔쳐온다.
+    {
+        ShardedRingBuffer buffer(2, CHECK_PARAM::BUFFER_SIZE, 2);
+        buffer.put(1, 42);
+        expect(buffer.get(0) == 42, errors);
+        expect(throws<EmptyBufferReadException>([&]() { buffer.get(1); }), errors);
+        expect(throws<ShardedRingBufferException>([&]() { buffer.tryGet(2, item); }), errors);
+    }
+
+    // 모든 consumer가 home lane을 가질 수 없는 설정은 만들 수 없다.
+    expect(throws<ShardedRingBufferException>([]() { ShardedRingBuffer buffer(0, 4, 1); }), errors);
+    expect(throws<ShardedRingBufferException>([]() { ShardedRingBuffer buffer(4, 4, 0); }), errors);
+    expect(throws<ShardedRingBufferException>([]() { ShardedRingBuffer buffer(1, 4, 2, true); }), errors);
+
+    return errors;
+}
+
+
+int checkBroadcast() {
+
+    int errors = 0;
+
+    // 모든 consumer가 모든 데이터를 순서대로 읽는다.
+    {
+        BroadcastRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE, 2);
+        int next = 0;
+
+        for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+            for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE; ++i)
+                buffer.putWithoutOverride(next + (int)i);
+            buffer.put(-1); // 가장 느린 consumer보다 한 바퀴 앞설 수 없으므로 버려진다.
+
+            for (size_t consumer=0; consumer<2; ++consumer) {
+                for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE; ++i)
+                    expect(buffer.get(consumer) == next + (int)i, errors);
+                expect(throws<EmptyBufferReadException>([&]() { buffer.get(consumer); }), errors);
+            }
+            next += (int)CHECK_PARAM::BUFFER_SIZE;
+        }
+    }
+
+    // DROP이면 한 바퀴 뒤처진 consumer를 제외하고, rejoin하면 최신 위치부터 읽는다.
+    {
+        BroadcastRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE, 2, SlowConsumerPolicy::DROP);
+
+        for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE; ++i)
+            buffer.put((int)i);
+        for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE; ++i)
+            expect(buffer.get(0) == (int)i, errors);
+        buffer.put(100);
+
+        expect(buffer.get(0) == 100, errors);
+        expect(buffer.isDropped(1), errors);
+        expect(throws<ConsumerDroppedException>([&]() { buffer.get(1); }), errors);
+
+        buffer.rejoin(1);
+        expect(!buffer.isDropped(1), errors);
+        expect(throws<EmptyBufferReadException>([&]() { buffer.get(1); }), errors);
+        buffer.put(101);
+        expect(buffer.get(1) == 101, errors);
+        expect(buffer.get(0) == 101, errors);
+    }
+
+    return errors;
+}
+
+
+int checkPriority() {
+
+    int errors = 0;
+    int item;
+    size_t priority;
+
+    // class 0이 항상 먼저 나오고, class 안에서는 FIFO이다. class마다 따로 가득 찬다.
+    {
+        PriorityRingBuffer buffer(3, CHECK_PARAM::BUFFER_SIZE);
+
+        for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+            for (size_t p=3; p-- > 0;)
+                for (size_t i=0; i<=CHECK_PARAM::BUFFER_SIZE; ++i)
+                    buffer.put(p, (int)(p * 100 + i)); // 마지막 하나는 버려진다.
+
+            for (size_t p=0; p<3; ++p) {
+                for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE; ++i) {
+                    expect(buffer.tryGet(item, priority), errors);
+                    expect(priority == p && item == (int)(p * 100 + i), errors);
+                }
+            }
+            expect(!buffer.tryGet(item, priority), errors);
+            expect(throws<EmptyBufferReadException>([&]() { buffer.get(); }), errors);
+        }
+    }
+
+    // starvationLimit번 연속으로 밀린 class는 다음에 한 번 먼저 꺼내진다.
+    {
+        const size_t limit = 3, high = 12, low = 3;
+        PriorityRingBuffer buffer(2, high, limit);
+
+        for (size_t i=0; i<high; ++i)
+            buffer.put(0, (int)i);
+        for (size_t i=0; i<low; ++i)
+            buffer.put(1, (int)(100 + i));
+
+        size_t nextHigh = 0, nextLow = 0, run = 0;
+        for (size_t i=0; i<high + low; ++i) {
+            expect(buffer.tryGet(item, priority), errors);
+            if (priority == 0) {
+                expect(item == (int)nextHigh++, errors);
+                if (nextLow < low)
+                    expect(++run <= limit, errors);
+            }
+            else {
+                expect(item == (int)(100 + nextLow++), errors);
+                expect(nextHigh == nextLow * limit, errors);
+                run = 0;
+            }
+        }
+        expect(!buffer.tryGet(item, priority), errors);
+    }
+
+    return errors;
+}
+
+
+int checkElastic() {
+
+    int errors = 0;
+    ElasticOptions options;
+    options.segmentSize = CHECK_PARAM::BUFFER_SIZE;
+    options.minSegments = 1;
+    options.maxSegments = 3;
+    options.idlePeriod = chrono::milliseconds(0);
+    ElasticRingBuffer buffer(options);
+
+    const size_t maxCapacity = options.segmentSize * options.maxSegments;
+    int next = 0;
+
+    for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+        // 최대 용량까지 늘어나고, 그 다음 put은 버려진다.
+        for (size_t i=0; i<maxCapacity + 1; ++i)
+            buffer.put(next + (int)i);
+        expect(buffer.capacity() == maxCapacity, errors);
+        expect(buffer.size() == maxCapacity, errors);
+
+        // segment 경계를 넘어도 FIFO이다.
+        for (size_t i=0; i<maxCapacity; ++i)
+            expect(buffer.get() == next + (int)i, errors);
+        expect(throws<EmptyBufferReadException>([&]() { buffer.get(); }), errors);
+
+        // 비어 있는 상태가 idlePeriod(0) 이상 계속되면 minSegments까지 줄어든다.
+        for (size_t i=0; i<options.maxSegments * 2; ++i)
+            buffer.shrinkIfIdle();
+        expect(buffer.capacity() == options.segmentSize * options.minSegments, errors);
+
+        next += (int)maxCapacity;
+    }
+
+    return errors;
+}
+
+
+int checkSpill() {
+
+    int errors = 0;
+    const size_t segmentItems = 8, maxSegments = 4;
+    SpillRingBuffer buffer(CHECK_PARAM::BUFFER_SIZE, CHECK_PARAM::SPILL_DIRECTORY, segmentItems, maxSegments);
+    const size_t total = CHECK_PARAM::BUFFER_SIZE + segmentItems * maxSegments;
+    int next = 0;
+
+    for (size_t round=0; round<CHECK_PARAM::ROUNDS; ++round) {
+        // 메모리 버퍼와 모든 segment를 채우면 그 다음 put은 버려진다.
+        for (size_t i=0; i<total; ++i)
+            buffer.putWithoutOverride(next + (int)i);
+        expect(buffer.spilled() == total - CHECK_PARAM::BUFFER_SIZE, errors);
+        buffer.put(-1);
+        expect(buffer.dropped() == round + 1, errors);
+
+        // 메모리 버퍼에 빈 공간이 생겨도 spill에 남은 데이터보다 먼저 읽히면 안 된다.
+        for (size_t i=0; i<CHECK_PARAM::BUFFER_SIZE + segmentItems; ++i)
+            expect(buffer.get() == next + (int)i, errors);
+        for (size_t i=0; i<segmentItems; ++i)
+            buffer.putWithoutOverride(next + (int)(total + i));
+
+        for (size_t i=CHECK_PARAM::BUFFER_SIZE + segmentItems; i<total + segmentItems; ++i)
+            expect(buffer.getFromNotEmptyBuffer() == next + (int)i, errors);
+        expect(buffer.spilled() == 0, errors);
+        expect(throws<EmptyBufferReadException>([&]() { buffer.get(); }), errors);
+
+        next += (int)(total + segmentItems);
+    }
+
+    return errors;
+}
+
+
+/**
+ * @brief 여러 word에 걸친 값. word 단위로 찢어지면 field가 서로 달라진다.
+ */
+typedef struct check_sample {
+    uint64_t a;
+    uint64_t b;
+    uint32_t c;
+} CheckSample;
+
+
+int checkLatestValue() {
+
+    int errors = 0;
+    LatestValue<CheckSample> value;
+    CheckSample sample;
+    uint64_t lastSeen = 0;
+
+    expect(value.version() == 0, errors);
+    expect(!value.readIfNewer(sample, lastSeen), errors);
+
+    for (uint64_t i=1; i<=CHECK_PARAM::ROUNDS; ++i) {
+        CheckSample stored = { i, i * 2, (uint32_t)(i * 3) };
+        value.store(stored);
+
+        expect(value.version() == i, errors);
+        expect(value.readIfNewer(sample, lastSeen), errors);
+        expect(lastSeen == i && sample.a == i && sample.b == i * 2 && sample.c == i * 3, errors);
+        expect(!value.readIfNewer(sample, lastSeen), errors);
+    }
+
+    // 여러 번 저장하면 마지막 값만 남는다.
+    CheckSample first = { 100, 200, 300 }, last = { 101, 202, 303 };
+    value.store(first);
+    value.store(last);
+    sample = value.load();
+    expect(value.readIfNewer(sample, lastSeen) && lastSeen == CHECK_PARAM::ROUNDS + 2, errors);
+    expect(sample.a == 101 && sample.b == 202 && sample.c == 303, errors);
+
+    return errors;
+}
+
+
+/**
+ * @brief SIMD kernel과 scalar kernel이 모든 길이와 나누는 위치에서 같은 결과를 내는지 비교한다.
+ */
+int checkWindowKernels() {
+
+    int errors = 0;
+    mt19937 random(CHECK_PARAM::SEED);
+    uniform_int_distribution<int> small(-8, 8);
+    vector<int> items(CHECK_PARAM::WINDOW_LENGTH);
+
+    vector<WindowKernel> kernels;
+    kernels.push_back(accumulateScalar);
+#ifdef WINDOW_AGGREGATE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back(accumulateAvx2);
+    if (__builtin_cpu_supports("sse4.1"))
+        kernels.push_back(accumulateSse41);
+#endif
+    kernels.push_back(accumulateWindow);
+
+    const int thresholds[] = { 0, 3, INT_MIN, INT_MAX };
+    for (size_t length=0; length<=CHECK_PARAM::WINDOW_LENGTH; ++length) {
+        // 작은 값은 threshold 부근을 자주 오가고, 끝 값은 min/max와 합의 경계를 확인한다.
+        for (size_t i=0; i<length; ++i)
+            items[i] = (i % 17 == 5) ? INT_MAX : (i % 19 == 7) ? INT_MIN : small(random);
+
+        for (int threshold : thresholds) {
+            WindowAggregate expected = emptyWindowAggregate();
+            for (size_t i=0; i<length; ++i)
+                step(items[i], threshold, expected);
+
+            for (WindowKernel kernel : kernels) {
+                WindowAggregate whole = emptyWindowAggregate();
+                kernel(items.data(), length, threshold, whole);
+                expect(isSameAggregate(whole, expected), errors);
+
+                // visitWindow처럼 두 구간으로 나누어 이어서 집계해도 같아야 한다.
+                for (size_t split=1; split<length; split+=7) {
+                    WindowAggregate chained = emptyWindowAggregate();
+                    kernel(items.data(), split, threshold, chained);
+                    kernel(items.data() + split, length - split, threshold, chained);
+                    expect(isSameAggregate(chained, expected), errors);
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+
+int main() {
+
+    bool isFailed = false;
+
+    isFailed |= report("RingBuffer", checkRingBuffer());
+    isFailed |= report("SpscRingBuffer", checkSpsc());
+    isFailed |= report("MpmcRingBuffer", checkMpmc());
+    isFailed |= report("OverwriteRingBuffer", checkOverwrite());
+    isFailed |= report("ShmRingBuffer", checkShm());
+    isFailed |= report("RecordRingBuffer", checkRecord());
+    isFailed |= report("ShardedRingBuffer", checkSharded());
+    isFailed |= report("BroadcastRingBuffer", checkBroadcast());
+    isFailed |= report("PriorityRingBuffer", checkPriority());
+    isFailed |= report("ElasticRingBuffer", checkElastic());
+    isFailed |= report("SpillRingBuffer", checkSpill());
+    isFailed |= report("LatestValue", checkLatestValue());
+    isFailed |= report("window kernels", checkWindowKernels());
+
+    return isFailed ? 1 : 0;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file elasticringbuffer.cpp
+ * @brief Segmented RingBuffer whose capacity grows under backpressure and shrinks when idle
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <algorithm>
+
+#include "elasticringbuffer.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief Default Constructor which uses the default ElasticOptions.
+     */
+    ElasticRingBuffer::ElasticRingBuffer(): ElasticRingBuffer(ElasticOptions()) {
+    }
+
+
+    /**
+     * @brief minSegments 크기로 시작하는 버퍼를 만든다.
+     *
+     * @param options 크기 조절 기준
+     */
+    ElasticRingBuffer::ElasticRingBuffer(const ElasticOptions& options): _options(options) {
+        _head = 0;
+        _tail = 0;
+        _count = 0;
+        _capacitySegments = max(_options.minSegments, (size_t)1);
+        _isLow = false;
+    }
+
+
+    ElasticRingBuffer::~ElasticRingBuffer() {
+        for (size_t i=0; i<_segments.size(); ++i)
+            delete [] _segments[i];
+        for (size_t i=0; i<_spares.size(); ++i)
+            delete [] _spares[i];
+    }
+
+
+    size_t ElasticRingBuffer::capacityLocked() const noexcept {
+        return _capacitySegments * _options.segmentSize;
+    }
+
+
+    bool ElasticRingBuffer::isFull() const noexcept {
+        return _count >= capacityLocked();
+    }
+
+
+    /**
+     * @brief maxSegments보다 작으면 용량을 한 segment 늘린다. _mutex를 잡은 상태에서 호출해야 한다.
+     *
+     * @return 늘렸으면 true
+     */
+    bool ElasticRingBuffer::grow() noexcept {
+
+        if (_capacitySegments >= _options.maxSegments)
+            return false;
+
+        ++_capacitySegments;
+        _isLow = false;
+
+        return true;
+    }
+
+
+    /**
+     * @brief 현재 사용량에 따라 용량을 조절한다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    void ElasticRingBuffer::adjust() noexcept {
+
+        double capacity = (double)capacityLocked();
+
+        if (_count >= _options.growOccupancy * capacity) {
+            grow();
+            return;
+        }
+
+        if (_count >= _options.shrinkOccupancy * capacity || _capacitySegments <= _options.minSegments) {
+            _isLow = false;
+            return;
+        }
+
+        // 사용량이 낮아진 뒤 idlePeriod가 지나야 줄인다. 그 전에는 시각만 기록한다.
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (!_isLow) {
+            _isLow = true;
+            _lowSince = now;
+            return;
+        }
+
+        if (now - _lowSince < _options.idlePeriod)
+            return;
+
+        if (_count <= capacityLocked() - _options.segmentSize) {
+            --_capacitySegments;
+            trimSpares();
+        }
+        _lowSince = now;
+    }
+
+
+    /**
+     * @brief 용량보다 많이 남은 segment의 메모리를 해제한다. _mutex를 잡은 상태에서 호출해야 한다.
+     * 첫 segment를 중간부터 읽는 중일 수 있으므로 사용 중인 segment는 용량보다 하나 많을 수 있다.
+     */
+    void ElasticRingBuffer::trimSpares() noexcept {
+
+        size_t limit = _capacitySegments + 1;
+
+        while (!_spares.empty() && _segments.size() + _spares.size() > limit) {
+            delete [] _spares.back();
+            _spares.pop_back();
+        }
+    }
+
+
+    /**
+     * @brief 마지막 segment에 저장한다. 공간이 없으면 segment를 추가한다.
+     * _mutex를 잡은 상태에서 가득 차지 않았을 때만 호출해야 한다.
+     */
+    void ElasticRingBuffer::push(int item) {
+
+        if (_segments.empty() || _tail == _options.segmentSize) {
+            int* pSegment;
+            if (_spares.empty()) {
+                pSegment = new int[_options.segmentSize];
+            }
+            else {
+                pSegment = _spares.back();
+                _spares.pop_back();
+            }
+            _segments.push_back(pSegment);
+            _tail = 0;
+        }
+
+        _segments.back()[_tail++] = item;
+        ++_count;
+    }
+
+
+    /**
+     * @brief 첫 segment에서 가장 오래된 값을 꺼낸다. 다 읽은 segment는 재사용 목록으로 돌려준다.
+     * _mutex를 잡은 상태에서 비어 있지 않을 때만 호출해야 한다.
+     */
+    int ElasticRingBuffer::pop() noexcept {
+
+        int item = _segments.front()[_head++];
+        --_count;
+
+        if (_head == _options.segmentSize) {
+            _spares.push_back(_segments.front());
+            _segments.pop_front();
+            _head = 0;
+            trimSpares();
+        }
+        else if (_count == 0) {
+            // 하나 남은 segment를 처음부터 다시 쓴다.
+            _head = 0;
+            _tail = 0;
+        }
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 없으면 용량을 늘리고, 최대 용량이면 값을 쓰지 않는다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void ElasticRingBuffer::put(int item) {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isFull() && !grow())
+            return;
+
+        push(item);
+        adjust();
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 없으면 용량을 늘리고, 최대 용량이면 빈 공간이 생길때까지 대기한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void ElasticRingBuffer::putWithoutOverride(int item) {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isFull())
+            grow();
+        _notFull.wait(lock, [this]() { return !isFull(); });
+
+        push(item);
+        adjust();
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+
+    /**
+     * @brief get()과 같지만 버퍼가 비어 있으면 예외 대신 false를 반환한다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼냈으면 true, 버퍼가 비어 있으면 false.
+     */
+    bool ElasticRingBuffer::tryGet(int& item) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (_count == 0)
+            return false;
+
+        item = pop();
+        adjust();
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_one();
+
+        return true;
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int ElasticRingBuffer::get() {
+
+        int item;
+
+        if (!tryGet(item))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int ElasticRingBuffer::getFromNotEmptyBuffer() {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        _notEmpty.wait(lock, [this]() { return _count > 0; });
+
+        int item = pop();
+        adjust();
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_one();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 현재 용량. 저장할 수 있는 데이터 개수의 상한이다.
+     */
+    size_t ElasticRingBuffer::capacity() noexcept {
+        lock_guard<mutex> lock(_mutex);
+        return capacityLocked();
+    }
+
+
+    size_t ElasticRingBuffer::size() noexcept {
+        lock_guard<mutex> lock(_mutex);
+        return _count;
+    }
+
+
+    /**
+     * @brief 접근이 없는 동안에도 줄어들 수 있도록 사용량을 다시 확인한다. 주기적으로 호출한다.
+     */
+    void ElasticRingBuffer::shrinkIfIdle() noexcept {
+        lock_guard<mutex> lock(_mutex);
+        adjust();
+    }
+
+}; // rtos
@@ -0,0 +1,108 @@
+/**
+ * @file elasticringbuffer.h
+ * @brief Segmented RingBuffer whose capacity grows under backpressure and shrinks when idle
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _ELASTIC_RING_BUFFER_H_
+#define _ELASTIC_RING_BUFFER_H_
+
+#include <cstddef>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**@struct ElasticOptions
+     * @brief ElasticRingBuffer의 크기 조절 기준.
+     * @var ElasticOptions::segmentSize
+     * 한 번에 늘리거나 줄이는 크기
+     * @var ElasticOptions::minSegments
+     * 최소 용량 (segment 개수)
+     * @var ElasticOptions::maxSegments
+     * 최대 용량 (segment 개수)
+     * @var ElasticOptions::growOccupancy
+     * 저장된 데이터가 용량의 이 비율 이상이 되면 segment를 하나 늘린다.
+     * @var ElasticOptions::shrinkOccupancy
+     * 저장된 데이터가 용량의 이 비율보다 적은 상태가 idlePeriod 동안 계속되면 segment를 하나 줄인다.
+     * @var ElasticOptions::idlePeriod
+     * 줄이기 전에 기다리는 시간
+     */
+    typedef struct elastic_options {
+        size_t segmentSize = 64;
+        size_t minSegments = 1;
+        size_t maxSegments = 16;
+        double growOccupancy = 0.75;
+        double shrinkOccupancy = 0.25;
+        chrono::milliseconds idlePeriod = chrono::milliseconds(1000);
+    } ElasticOptions;
+
+
+    /**
+     * @brief 용량이 부하에 따라 segment 단위로 늘고 줄어드는 RingBuffer.
+     *
+     * 데이터는 고정 크기 segment들의 목록에 저장된다. producer는 마지막 segment에 쓰고
+     * consumer는 첫 segment부터 읽으며, 다 읽은 segment는 재사용 목록으로 돌려준다.
+     * 용량은 저장할 수 있는 데이터 개수의 상한일 뿐이므로 늘리거나 줄일 때 데이터를 옮기지 않고,
+     * producer와 consumer를 멈추지 않으며, FIFO 순서도 그대로 유지된다.
+     *
+     * 저장된 데이터가 growOccupancy 이상이 되거나 가득 찬 버퍼에 put하면(데이터 손실 직전)
+     * maxSegments까지 한 segment씩 늘린다. 사용량이 shrinkOccupancy보다 적은 상태가 idlePeriod 동안
+     * 계속되면 minSegments까지 한 segment씩 줄이고 남는 segment의 메모리를 해제한다.
+     * 줄이는 조건은 put/get 때 확인하므로, 접근이 없는 버퍼는 shrinkIfIdle()을 주기적으로 호출한다.
+     */
+    class ElasticRingBuffer {
+
+        private:
+            const ElasticOptions _options;
+            deque<int*> _segments; // 사용 중인 segment. 앞에서 읽고 뒤에 쓴다.
+            vector<int*> _spares; // 재사용할 segment
+            size_t _head; // 첫 segment에서 다음에 읽을 위치
+            size_t _tail; // 마지막 segment에서 다음에 쓸 위치
+            size_t _count; // 저장된 데이터 개수
+            size_t _capacitySegments; // 현재 용량 (segment 개수)
+            chrono::steady_clock::time_point _lowSince; // 사용량이 낮아진 시각
+            bool _isLow;
+            mutex _mutex;
+            condition_variable _notEmpty;
+            condition_variable _notFull;
+
+            size_t capacityLocked() const noexcept;
+            bool isFull() const noexcept;
+            bool grow() noexcept;
+            void adjust() noexcept;
+            void trimSpares() noexcept;
+            void push(int item);
+            int pop() noexcept;
+
+        public:
+            ElasticRingBuffer();
+            explicit ElasticRingBuffer(const ElasticOptions& options);
+            ~ElasticRingBuffer();
+
+            ElasticRingBuffer(const ElasticRingBuffer&) = delete;
+            ElasticRingBuffer& operator=(const ElasticRingBuffer&) = delete;
+
+            void put (int item);
+            void putWithoutOverride (int item);
+            int get();
+            int getFromNotEmptyBuffer ();
+            bool tryGet (int& item) noexcept;
+
+            size_t capacity () noexcept;
+            size_t size () noexcept;
+            void shrinkIfIdle () noexcept;
+
+    }; // ElasticRingBuffer
+
+}; // rtos
+
+#endif // _ELASTIC_RING_BUFFER_H_
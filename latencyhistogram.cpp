@@ -0,0 +1,124 @@
+/**
+ * @file latencyhistogram.cpp
+ * @brief Lock-free histogram with power-of-two latency buckets
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include "latencyhistogram.h"
+
+
+namespace rtos {
+
+
+    LatencyHistogram::LatencyHistogram() {
+        reset();
+    }
+
+
+    /**
+     * @brief 지연 시간 하나를 기록한다.
+     *
+     * @param nanos 지연 시간(ns)
+     */
+    void LatencyHistogram::record(uint64_t nanos) noexcept {
+
+        _buckets[bucketOf(nanos)].fetch_add(1, memory_order_relaxed);
+        _count.fetch_add(1, memory_order_relaxed);
+        _sum.fetch_add(nanos, memory_order_relaxed);
+
+        uint64_t max = _max.load(memory_order_relaxed);
+        while (nanos > max && !_max.compare_exchange_weak(max, nanos, memory_order_relaxed))
+            ;
+    }
+
+
+    /**
+     * @brief 모든 기록을 지운다. 동시에 기록 중인 값은 일부만 지워질 수 있다.
+     */
+    void LatencyHistogram::reset() noexcept {
+        for (size_t i=0; i<LATENCY_BUCKETS; ++i)
+            _buckets[i].store(0, memory_order_relaxed);
+        _count.store(0, memory_order_relaxed);
+        _sum.store(0, memory_order_relaxed);
+        _max.store(0, memory_order_relaxed);
+    }
+
+
+    uint64_t LatencyHistogram::count() const noexcept {
+        return _count.load(memory_order_relaxed);
+    }
+
+
+    uint64_t LatencyHistogram::max() const noexcept {
+        return _max.load(memory_order_relaxed);
+    }
+
+
+    double LatencyHistogram::mean() const noexcept {
+        uint64_t count = _count.load(memory_order_relaxed);
+        return count == 0 ? 0.0 : (double)_sum.load(memory_order_relaxed) / count;
+    }
+
+
+    /**
+     * @brief 기록된 값 중 p 비율 이하가 속하는 구간의 상한. 기록이 없으면 0.
+     *
+     * @param p 0.0 ~ 1.0 (예: 0.99)
+     *
+     * @return 지연 시간(ns). max()보다 크지 않다.
+     */
+    uint64_t LatencyHistogram::percentile(double p) const noexcept {
+
+        uint64_t total = 0;
+        uint64_t counts[LATENCY_BUCKETS];
+        for (size_t i=0; i<LATENCY_BUCKETS; ++i) {
+            counts[i] = _buckets[i].load(memory_order_relaxed);
+            total += counts[i];
+        }
+
+        if (total == 0)
+            return 0;
+
+        uint64_t rank = (uint64_t)(p * total);
+        if (rank == 0)
+            rank = 1;
+
+        uint64_t seen = 0;
+        uint64_t max = _max.load(memory_order_relaxed);
+        for (size_t i=0; i<LATENCY_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank)
+                return bucketUpperBound(i) < max ? bucketUpperBound(i) : max;
+        }
+
+        return max;
+    }
+
+
+    uint64_t LatencyHistogram::bucketCount(size_t bucket) const noexcept {
+        return _buckets[bucket].load(memory_order_relaxed);
+    }
+
+
+    /**
+     * @brief nanos가 속하는 구간. 0은 0번, 그 외에는 [2^(i-1), 2^i) 구간이 i번이다.
+     */
+    size_t LatencyHistogram::bucketOf(uint64_t nanos) noexcept {
+        return nanos == 0 ? 0 : 64 - __builtin_clzll(nanos);
+    }
+
+
+    /**
+     * @brief bucket 구간에 속하는 가장 큰 값.
+     */
+    uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) noexcept {
+        if (bucket == 0)
+            return 0;
+        if (bucket >= 64)
+            return UINT64_MAX;
+        return (UINT64_C(1) << bucket) - 1;
+    }
+
+}; // rtos
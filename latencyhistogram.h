@@ -0,0 +1,57 @@
+/**
+ * @file latencyhistogram.h
+ * @brief Lock-free histogram with power-of-two latency buckets
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _LATENCY_HISTOGRAM_H_
+#define _LATENCY_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+namespace rtos {
+
+    const size_t LATENCY_BUCKETS = 65; // 0ns와 [2^(i-1), 2^i)ns 구간 64개
+
+    /**
+     * @brief 지연 시간(ns)의 분포를 2의 거듭제곱 구간별로 세는 histogram.
+     *
+     * record는 relaxed atomic만 사용하므로 여러 쓰레드가 lock 없이 기록할 수 있고,
+     * 기록 중에도 다른 쓰레드가 조회할 수 있다. 조회 결과는 구간의 상한이므로 최대 2배까지 크게 나온다.
+     */
+    class LatencyHistogram {
+
+        private:
+            atomic<uint64_t> _buckets[LATENCY_BUCKETS];
+            atomic<uint64_t> _count;
+            atomic<uint64_t> _sum;
+            atomic<uint64_t> _max;
+
+        public:
+            LatencyHistogram();
+
+            LatencyHistogram(const LatencyHistogram&) = delete;
+            LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+            void record (uint64_t nanos) noexcept;
+            void reset () noexcept;
+
+            uint64_t count () const noexcept;
+            uint64_t max () const noexcept;
+            double mean () const noexcept;
+            uint64_t percentile (double p) const noexcept;
+
+            uint64_t bucketCount (size_t bucket) const noexcept;
+            static size_t bucketOf (uint64_t nanos) noexcept;
+            static uint64_t bucketUpperBound (size_t bucket) noexcept;
+
+    }; // LatencyHistogram
+
+}; // rtos
+
+#endif // _LATENCY_HISTOGRAM_H_
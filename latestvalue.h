@@ -0,0 +1,157 @@
+/**
+ * @file latestvalue.h
+ * @brief Header-only seqlock register that keeps only the newest value
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _LATEST_VALUE_H_
+#define _LATEST_VALUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+#include "storage.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 가장 최근 값 하나만 유지하는 seqlock register. 현재 설정값, 최신 센서 값처럼
+     * 지난 값이 필요 없는 상태를 전달할 때 RingBuffer 대신 사용한다.
+     *
+     * writer는 하나이며 store는 기다리지 않는다(wait-free). reader는 mutex 없이 아무 때나 읽을 수 있고,
+     * 읽는 도중 값이 바뀌면 다시 읽으므로 writer를 막지 않는다. 여러 쓰레드가 store하려면 밖에서 직렬화해야 한다.
+     *
+     * version은 store할 때마다 1씩 증가하는 변경 횟수이다. readIfNewer로 이미 읽은 값을 건너뛸 수 있다.
+     * 값은 atomic word 단위로 복사하므로 T는 trivially copyable이어야 한다.
+     */
+    template <typename T>
+    class LatestValue {
+
+        static_assert(is_trivially_copyable<T>::value, "LatestValue<T> requires a trivially copyable T");
+
+        private:
+            static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+            // 홀수이면 쓰는 중이다. version은 _sequence / 2이다.
+            alignas(CACHE_LINE_SIZE) atomic<uint64_t> _sequence;
+            atomic<uint64_t> _words[WORDS];
+
+            static inline void relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+                asm volatile("yield");
+#endif
+            }
+
+            void storeWords(const T& value) noexcept {
+                uint64_t words[WORDS] = {};
+                memcpy(words, &value, sizeof(T));
+                for (size_t i=0; i<WORDS; ++i)
+                    _words[i].store(words[i], memory_order_relaxed);
+            }
+
+        public:
+            /**
+             * @brief version 0, 값이 T()인 상태로 만든다.
+             */
+            LatestValue(): LatestValue(T()) {}
+
+            explicit LatestValue(const T& initial) {
+                _sequence.store(0, memory_order_relaxed);
+                storeWords(initial);
+            }
+
+            LatestValue(const LatestValue&) = delete;
+            LatestValue& operator=(const LatestValue&) = delete;
+
+
+            /**
+             * @brief 값을 바꾼다. writer 쓰레드 하나에서만 호출해야 한다.
+             *
+             * @param value 새로운 값.
+             */
+            void store (const T& value) noexcept {
+
+                uint64_t sequence = _sequence.load(memory_order_relaxed);
+
+                _sequence.store(sequence + 1, memory_order_relaxed);
+                atomic_thread_fence(memory_order_release); // 값보다 홀수 sequence가 먼저 보이게 한다.
+                storeWords(value);
+                _sequence.store(sequence + 2, memory_order_release);
+            }
+
+
+            /**
+             * @brief 현재 값을 읽는다. 쓰는 중이면 끝날 때까지 다시 읽는다.
+             *
+             * @param value 읽은 값을 저장할 변수.
+             *
+             * @return 읽은 값의 version.
+             */
+            uint64_t load (T& value) const noexcept {
+
+                uint64_t words[WORDS];
+
+                while (true) {
+                    uint64_t before = _sequence.load(memory_order_acquire);
+                    if (before & 1) {
+                        relax();
+                        continue;
+                    }
+
+                    for (size_t i=0; i<WORDS; ++i)
+                        words[i] = _words[i].load(memory_order_relaxed);
+
+                    atomic_thread_fence(memory_order_acquire); // 값을 다 읽은 뒤에 sequence를 다시 읽는다.
+                    if (_sequence.load(memory_order_relaxed) == before) {
+                        memcpy(&value, words, sizeof(T));
+                        return before / 2;
+                    }
+                }
+            }
+
+            T load () const noexcept {
+                T value;
+                load(value);
+                return value;
+            }
+
+
+            /**
+             * @brief lastSeen 이후에 값이 바뀌었으면 읽는다. 바뀌지 않았으면 atomic load 한 번으로 끝난다.
+             *
+             * @param value 읽은 값을 저장할 변수.
+             * @param lastSeen 마지막으로 읽은 version. 처음에는 0이며, 읽으면 새 version으로 바뀐다.
+             *
+             * @return 새로운 값을 읽었으면 true.
+             */
+            bool readIfNewer (T& value, uint64_t& lastSeen) const noexcept {
+
+                if (version() == lastSeen)
+                    return false;
+
+                lastSeen = load(value);
+
+                return true;
+            }
+
+
+            /**
+             * @brief 지금까지 store한 횟수. 쓰는 중이면 이전 값의 version이다.
+             */
+            uint64_t version () const noexcept {
+                return _sequence.load(memory_order_acquire) / 2;
+            }
+
+    }; // LatestValue
+
+}; // rtos
+
+#endif // _LATEST_VALUE_H_
@@ -0,0 +1,196 @@
+/**
+ * @file mpmcringbuffer.cpp
+ * @brief Lock-free multi-producer/multi-consumer RingBuffer implementation
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <thread>
+
+#include "mpmcringbuffer.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief Default Constructor which creates a buffer of length 10.
+     */
+    MpmcRingBuffer::MpmcRingBuffer(): MpmcRingBuffer(10) {
+    }
+
+
+    /**
+     * @brief Creates a ring buffer of length n.
+     *
+     * @param n Buffer size. MPMC_MIN_BUFFER_SIZE보다 작으면 MPMC_MIN_BUFFER_SIZE로 만든다.
+     */
+    MpmcRingBuffer::MpmcRingBuffer(size_t n): BUFFER_SIZE(n < MPMC_MIN_BUFFER_SIZE ? MPMC_MIN_BUFFER_SIZE : n) {
+        _pBuffer = new Slot[BUFFER_SIZE];
+        for (size_t i=0; i<BUFFER_SIZE; ++i)
+            _pBuffer[i].sequence.store(i, memory_order_relaxed);
+        _front.store(0, memory_order_relaxed);
+        _back.store(0, memory_order_relaxed);
+    }
+
+
+    MpmcRingBuffer::~MpmcRingBuffer() {
+        delete [] _pBuffer;
+    }
+
+
+    /**
+     * @brief 빈 slot을 하나 차지하여 값을 저장한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     *
+     * @return 저장에 성공하면 true, 버퍼가 가득 찼으면 false.
+     */
+    bool MpmcRingBuffer::push(int item) noexcept {
+
+        size_t pos = _front.load(memory_order_relaxed);
+        Slot* pSlot;
+
+        while (true) {
+            pSlot = &_pBuffer[pos % BUFFER_SIZE];
+            size_t seq = pSlot->sequence.load(memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+            if (diff == 0) {
+                // slot이 비어 있다. 다른 producer보다 먼저 차지해야 한다.
+                if (_front.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                // consumer가 아직 이전 바퀴의 데이터를 꺼내지 않았다.
+                return false;
+            }
+            else {
+                // 다른 producer가 먼저 차지했다.
+                pos = _front.load(memory_order_relaxed);
+            }
+        }
+
+        pSlot->data = item;
+        pSlot->sequence.store(pos + 1, memory_order_release);
+
+        return true;
+    }
+
+
+    /**
+     * @brief 데이터가 저장된 slot을 하나 차지하여 값을 꺼낸다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼내는 데 성공하면 true, 버퍼가 비어 있으면 false.
+     */
+    bool MpmcRingBuffer::pop(int& item) noexcept {
+
+        size_t pos = _back.load(memory_order_relaxed);
+        Slot* pSlot;
+
+        while (true) {
+            pSlot = &_pBuffer[pos % BUFFER_SIZE];
+            size_t seq = pSlot->sequence.load(memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+            if (diff == 0) {
+                if (_back.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                // producer가 아직 이 slot에 쓰지 않았다.
+                return false;
+            }
+            else {
+                pos = _back.load(memory_order_relaxed);
+            }
+        }
+
+        item = pSlot->data;
+        // 다음 바퀴의 producer가 쓸 수 있도록 넘겨준다.
+        pSlot->sequence.store(pos + BUFFER_SIZE, memory_order_release);
+
+        return true;
+    }
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 없으면 값을 쓰지 않는다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void MpmcRingBuffer::put(int item) noexcept {
+        push(item);
+    }
+
+
+    /**
+     * @brief 데이터를 덮어쓰지 않고 빈 공간이 생길때까지 대기한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void MpmcRingBuffer::putWithoutOverride(int item) noexcept {
+        while (!push(item))
+            this_thread::yield();
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int MpmcRingBuffer::get() {
+
+        int item;
+
+        if (!pop(item))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int MpmcRingBuffer::getFromNotEmptyBuffer() noexcept {
+
+        int item;
+
+        while (!pop(item))
+            this_thread::yield();
+
+        return item;
+    }
+
+
+    /**
+     * @brief put()과 같지만 저장 여부를 반환한다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     *
+     * @return 저장했으면 true, 버퍼에 빈 공간이 없으면 false.
+     */
+    bool MpmcRingBuffer::tryPut(int item) noexcept {
+        return push(item);
+    }
+
+
+    /**
+     * @brief get()과 같지만 버퍼가 비어 있으면 예외 대신 false를 반환한다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼냈으면 true, 버퍼가 비어 있으면 false.
+     */
+    bool MpmcRingBuffer::tryGet(int& item) noexcept {
+        return pop(item);
+    }
+
+}; // rtos
@@ -0,0 +1,70 @@
+/**
+ * @file mpmcringbuffer.h
+ * @brief Lock-free multi-producer/multi-consumer RingBuffer interface
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _MPMC_RING_BUFFER_H_
+#define _MPMC_RING_BUFFER_H_
+
+#include <cstddef>
+#include <atomic>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    // 크기가 1이면 "쓸 수 있음"(pos)과 한 바퀴 전의 "읽을 수 있음"(pos + 1)을 구분할 수 없다.
+    const size_t MPMC_MIN_BUFFER_SIZE = 2;
+
+    /**
+     * @brief Producer와 Consumer가 여러 개인 경우에 사용하는 lock-free RingBuffer.
+     *
+     * 각 slot은 자신의 sequence 번호를 가진다. Producer는 _front에 대한 CAS로 slot 하나를
+     * 차지한 뒤 데이터를 쓰고 sequence를 갱신하여 consumer에게 넘긴다.
+     * 전역 lock이 없으므로 쓰레드들은 slot을 차지하는 순간에만 경쟁한다.
+     * 버퍼 크기는 최소 MPMC_MIN_BUFFER_SIZE이며, 더 작게 만들면 MPMC_MIN_BUFFER_SIZE로 올린다.
+     */
+    class MpmcRingBuffer {
+
+        private:
+            struct Slot {
+                atomic<size_t> sequence; // pos + 1이면 읽을 수 있고, pos이면 쓸 수 있다.
+                int data;
+            };
+
+            Slot* _pBuffer;
+            const size_t BUFFER_SIZE;
+
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _front; // 다음에 쓸 위치
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _back; // 다음에 읽을 위치
+
+            char _padding[CACHE_LINE_SIZE - sizeof(atomic<size_t>)];
+
+            bool push(int item) noexcept;
+            bool pop(int& item) noexcept;
+
+        public:
+            MpmcRingBuffer();
+            MpmcRingBuffer(size_t n);
+            ~MpmcRingBuffer();
+
+            MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+            MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+            void put (int item) noexcept;
+            void putWithoutOverride (int item) noexcept;
+            int get();
+            int getFromNotEmptyBuffer () noexcept;
+
+            bool tryPut (int item) noexcept;
+            bool tryGet (int& item) noexcept;
+
+    }; // MpmcRingBuffer
+
+}; // rtos
+
+#endif // _MPMC_RING_BUFFER_H_
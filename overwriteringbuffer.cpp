@@ -0,0 +1,198 @@
+/**
+ * @file overwriteringbuffer.cpp
+ * @brief RingBuffer that evicts the oldest entry when full
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <thread>
+
+#include "overwriteringbuffer.h"
+
+
+namespace rtos {
+
+    /**
+     * @brief 위치 번호와 데이터를 slot 하나의 값으로 합친다.
+     */
+    static inline uint64_t pack(size_t tag, int item) noexcept {
+        return ((uint64_t)(uint32_t)tag << 32) | (uint32_t)item;
+    }
+
+
+    static inline uint32_t tagOf(uint64_t state) noexcept {
+        return (uint32_t)(state >> 32);
+    }
+
+
+    static inline int itemOf(uint64_t state) noexcept {
+        return (int)(uint32_t)state;
+    }
+
+
+    /**
+     * @brief 32bit 위치 번호 a가 b보다 이전인지 비교한다. 한 바퀴를 넘는 차이도 2^31 이내이면 올바르다.
+     */
+    static inline bool isBefore(uint32_t a, uint32_t b) noexcept {
+        return (int32_t)(a - b) < 0;
+    }
+
+
+    /**
+     * @brief Default Constructor which creates a buffer of length 10.
+     */
+    OverwriteRingBuffer::OverwriteRingBuffer(): OverwriteRingBuffer(10) {
+    }
+
+
+    /**
+     * @brief Creates a ring buffer of length n.
+     *
+     * @param n Buffer size.
+     */
+    OverwriteRingBuffer::OverwriteRingBuffer(size_t n): BUFFER_SIZE(n) {
+        _pBuffer = new Slot[BUFFER_SIZE];
+        for (size_t i=0; i<BUFFER_SIZE; ++i)
+            _pBuffer[i].state.store(0, memory_order_relaxed);
+        _front.store(0, memory_order_relaxed);
+        _back.store(0, memory_order_relaxed);
+        _missed.store(0, memory_order_relaxed);
+    }
+
+
+    OverwriteRingBuffer::~OverwriteRingBuffer() {
+        delete [] _pBuffer;
+    }
+
+
+    /**
+     * @brief 버퍼에 값을 저장한다. 빈 공간이 없으면 가장 오래된 데이터를 덮어쓴다.
+     * 그 사이 다음 바퀴의 producer가 같은 slot에 먼저 저장했으면 이 값은 버린다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void OverwriteRingBuffer::put(int item) noexcept {
+
+        // 위치를 먼저 차지해야 consumer가 덮어쓰기를 감지할 수 있다.
+        size_t pos = _front.fetch_add(1, memory_order_acq_rel);
+        Slot& slot = _pBuffer[pos % BUFFER_SIZE];
+        uint64_t desired = pack(pos + 1, item);
+
+        uint64_t state = slot.state.load(memory_order_relaxed);
+        do {
+            if (!isBefore(tagOf(state), tagOf(desired)))
+                return;
+        } while (!slot.state.compare_exchange_weak(state, desired, memory_order_release, memory_order_relaxed));
+    }
+
+
+    /**
+     * @brief 가장 오래된 유효한 데이터를 꺼낸다. 이미 덮어써진 데이터는 건너뛴다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     * @param missed 이번 호출에서 건너뛴 데이터 개수를 저장할 변수.
+     *
+     * @return 꺼내는 데 성공하면 true, 읽을 데이터가 없으면 false.
+     */
+    bool OverwriteRingBuffer::pop(int& item, size_t& missed) noexcept {
+
+        size_t back = _back.load(memory_order_acquire);
+
+        while (true) {
+            size_t front = _front.load(memory_order_acquire);
+            if (back == front)
+                return false;
+
+            // producer가 한 바퀴 이상 앞서 있으면 남아 있는 가장 오래된 위치부터 읽는다.
+            size_t target = (front - back > BUFFER_SIZE) ? front - BUFFER_SIZE : back;
+            Slot& slot = _pBuffer[target % BUFFER_SIZE];
+
+            uint64_t state = slot.state.load(memory_order_acquire);
+            uint32_t tag = (uint32_t)(target + 1);
+
+            if (tagOf(state) != tag) {
+                // 아직 쓰는 중이면 비어 있는 것으로 본다. 덮어써진 경우에는 다시 시도한다.
+                if (isBefore(tagOf(state), tag) && _front.load(memory_order_acquire) - target <= BUFFER_SIZE)
+                    return false;
+                back = _back.load(memory_order_acquire);
+                continue;
+            }
+
+            if (_back.compare_exchange_weak(back, target + 1, memory_order_acq_rel)) {
+                item = itemOf(state);
+                missed = target - back;
+                if (missed > 0)
+                    _missed.fetch_add(missed, memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int OverwriteRingBuffer::get() {
+        size_t missed;
+        return get(missed);
+    }
+
+
+    /**
+     * @brief get()과 같지만 직전 get 이후 덮어써져 읽지 못한 데이터 개수를 함께 돌려준다.
+     *
+     * @param missed 건너뛴 데이터 개수를 저장할 변수.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int OverwriteRingBuffer::get(size_t& missed) {
+
+        int item;
+
+        if (!pop(item, missed))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int OverwriteRingBuffer::getFromNotEmptyBuffer() noexcept {
+        size_t missed;
+        return getFromNotEmptyBuffer(missed);
+    }
+
+
+    /**
+     * @brief getFromNotEmptyBuffer()와 같지만 건너뛴 데이터 개수를 함께 돌려준다.
+     *
+     * @param missed 건너뛴 데이터 개수를 저장할 변수.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int OverwriteRingBuffer::getFromNotEmptyBuffer(size_t& missed) noexcept {
+
+        int item;
+
+        while (!pop(item, missed))
+            this_thread::yield();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 지금까지 덮어써져 consumer가 읽지 못한 데이터의 총 개수.
+     */
+    size_t OverwriteRingBuffer::missed() const noexcept {
+        return _missed.load(memory_order_relaxed);
+    }
+
+}; // rtos
@@ -0,0 +1,69 @@
+/**
+ * @file overwriteringbuffer.h
+ * @brief RingBuffer that evicts the oldest entry when full
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _OVERWRITE_RING_BUFFER_H_
+#define _OVERWRITE_RING_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 버퍼가 가득 차면 가장 오래된 데이터를 덮어쓰는 RingBuffer. ("latest data wins")
+     *
+     * put은 lock 없이 위치를 하나 차지한 뒤 바로 쓰므로 producer는 절대 기다리지 않는다.
+     * 각 slot은 위치 번호(pos + 1의 하위 32bit)와 데이터를 하나의 64bit atomic에 함께 저장하므로,
+     * consumer가 읽은 데이터는 항상 함께 읽은 위치의 데이터이다. consumer는 이 번호로 덮어쓰기를 감지하고
+     * 건너뛴 데이터 개수(missed)를 돌려받는다.
+     *
+     * 하나의 slot을 서로 다른 바퀴의 producer가 동시에 쓰는 경우(용량보다 많은 producer가
+     * 동시에 멈춰 있는 경우) CAS로 더 최근 위치만 저장하고 늦은 producer의 데이터는 버리므로
+     * 해당 데이터는 missed로 처리된다. 위치 번호는 2^31 이내의 차이에서만 비교할 수 있다.
+     */
+    class OverwriteRingBuffer {
+
+        private:
+            struct Slot {
+                atomic<uint64_t> state; // 상위 32bit는 발행된 위치 + 1, 하위 32bit는 데이터. 0이면 비어 있다.
+            };
+
+            Slot* _pBuffer;
+            const size_t BUFFER_SIZE;
+
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _front; // 지금까지 저장된 데이터 개수
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _back; // 지금까지 꺼내거나 건너뛴 데이터 개수
+            atomic<size_t> _missed; // consumer가 건너뛴 데이터의 총 개수
+
+            bool pop(int& item, size_t& missed) noexcept;
+
+        public:
+            OverwriteRingBuffer();
+            OverwriteRingBuffer(size_t n);
+            ~OverwriteRingBuffer();
+
+            OverwriteRingBuffer(const OverwriteRingBuffer&) = delete;
+            OverwriteRingBuffer& operator=(const OverwriteRingBuffer&) = delete;
+
+            void put (int item) noexcept;
+            int get();
+            int get(size_t& missed);
+            int getFromNotEmptyBuffer () noexcept;
+            int getFromNotEmptyBuffer (size_t& missed) noexcept;
+
+            size_t missed() const noexcept;
+
+    }; // OverwriteRingBuffer
+
+}; // rtos
+
+#endif // _OVERWRITE_RING_BUFFER_H_
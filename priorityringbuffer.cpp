@@ -0,0 +1,235 @@
+/**
+ * @file priorityringbuffer.cpp
+ * @brief Set of per-priority rings with bitmask selection and starvation protection
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <algorithm>
+
+#include "priorityringbuffer.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief 가장 낮은 set bit의 위치. mask는 0이 아니어야 한다.
+     */
+    static inline size_t lowestBit(uint32_t mask) noexcept {
+        return (size_t)__builtin_ctz(mask);
+    }
+
+
+    /**
+     * @brief Creates classes rings of length n.
+     *
+     * @param classes 우선순위 class 개수. 최대 MAX_PRIORITY_CLASSES
+     * @param n class 하나의 버퍼 크기
+     * @param starvationLimit 낮은 class가 연속으로 밀릴 수 있는 최대 횟수. 0이면 엄격한 우선순위를 따른다.
+     */
+    PriorityRingBuffer::PriorityRingBuffer(size_t classes, size_t n, size_t starvationLimit):
+        CLASS_NUM(min(max(classes, (size_t)1), MAX_PRIORITY_CLASSES)), BUFFER_SIZE(n),
+        STARVATION_LIMIT(starvationLimit) {
+
+        _pBuffer = new int[CLASS_NUM * BUFFER_SIZE];
+        _pFront = new size_t[CLASS_NUM];
+        _pBack = new size_t[CLASS_NUM];
+        _pBypassed = new size_t[CLASS_NUM];
+        _pNotFull = new condition_variable[CLASS_NUM];
+        for (size_t i=0; i<CLASS_NUM; ++i) {
+            _pFront[i] = 0;
+            _pBack[i] = 0;
+            _pBypassed[i] = 0;
+        }
+        _nonEmpty = 0;
+        _starving = 0;
+    }
+
+
+    PriorityRingBuffer::~PriorityRingBuffer() {
+        delete [] _pBuffer;
+        delete [] _pFront;
+        delete [] _pBack;
+        delete [] _pBypassed;
+        delete [] _pNotFull;
+    }
+
+
+    bool PriorityRingBuffer::isFull(size_t priority) const noexcept {
+        return _pFront[priority] - _pBack[priority] == BUFFER_SIZE;
+    }
+
+
+    /**
+     * @brief priority class에 저장한다. _mutex를 잡은 상태에서 빈 공간이 있을 때만 호출한다.
+     */
+    void PriorityRingBuffer::push(size_t priority, int item) noexcept {
+        _pBuffer[priority * BUFFER_SIZE + _pFront[priority] % BUFFER_SIZE] = item;
+        ++_pFront[priority];
+        _nonEmpty |= (1u << priority);
+    }
+
+
+    /**
+     * @brief 이번에 꺼낼 class를 고르고, 밀린 class들의 건너뛴 횟수를 갱신한다.
+     * _mutex를 잡은 상태에서 _nonEmpty가 0이 아닐 때만 호출한다.
+     */
+    size_t PriorityRingBuffer::select() noexcept {
+
+        // 오래 밀린 class가 있으면 그 중 가장 높은 class를 먼저 처리한다.
+        uint32_t candidates = (_starving & _nonEmpty) ? (_starving & _nonEmpty) : _nonEmpty;
+        size_t chosen = lowestBit(candidates);
+
+        _pBypassed[chosen] = 0;
+        _starving &= ~(1u << chosen);
+
+        if (STARVATION_LIMIT == 0)
+            return chosen;
+
+        // 선택된 class보다 낮은 class 중 비어 있지 않은 class만 건너뛴 것으로 본다.
+        uint32_t lower = _nonEmpty & ~((2u << chosen) - 1);
+        while (lower) {
+            size_t priority = lowestBit(lower);
+            lower &= lower - 1;
+            if (++_pBypassed[priority] >= STARVATION_LIMIT)
+                _starving |= (1u << priority);
+        }
+
+        return chosen;
+    }
+
+
+    /**
+     * @brief priority class에서 가장 오래된 값을 꺼낸다. _mutex를 잡은 상태에서 호출한다.
+     */
+    int PriorityRingBuffer::pop(size_t priority) noexcept {
+
+        int item = _pBuffer[priority * BUFFER_SIZE + _pBack[priority] % BUFFER_SIZE];
+        ++_pBack[priority];
+
+        if (_pBack[priority] == _pFront[priority]) {
+            _nonEmpty &= ~(1u << priority);
+            _pBypassed[priority] = 0;
+            _starving &= ~(1u << priority);
+        }
+
+        return item;
+    }
+
+
+    /**
+     * @brief priority class에 빈 공간이 없으면 값을 쓰지 않는다.
+     *
+     * @param priority 우선순위 class. 0이 가장 높다. 범위를 넘으면 가장 낮은 class로 본다.
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void PriorityRingBuffer::put(size_t priority, int item) noexcept {
+
+        priority = min(priority, CLASS_NUM - 1);
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isFull(priority))
+            return;
+
+        push(priority, item);
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+
+    /**
+     * @brief priority class에 빈 공간이 생길 때까지 기다린 뒤 저장한다.
+     *
+     * @param priority 우선순위 class. 0이 가장 높다.
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void PriorityRingBuffer::putWithoutOverride(size_t priority, int item) noexcept {
+
+        priority = min(priority, CLASS_NUM - 1);
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        _pNotFull[priority].wait(lock, [this, priority]() { return !isFull(priority); });
+
+        push(priority, item);
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+
+    /**
+     * @brief 비어 있지 않은 가장 높은 class에서 값을 꺼낸다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     * @param priority 꺼낸 데이터의 class를 저장할 변수.
+     *
+     * @return 꺼냈으면 true, 모든 class가 비어 있으면 false.
+     */
+    bool PriorityRingBuffer::tryGet(int& item, size_t& priority) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (_nonEmpty == 0)
+            return false;
+
+        priority = select();
+        item = pop(priority);
+        /* Critical section end */
+
+        lock.unlock();
+        _pNotFull[priority].notify_one();
+
+        return true;
+    }
+
+
+    /**
+     * @brief 비어 있지 않은 가장 높은 class에서 값을 꺼낸다. 모든 class가 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int PriorityRingBuffer::get() {
+
+        int item;
+        size_t priority;
+
+        if (!tryGet(item, priority))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 모든 class가 비어 있는 경우 어느 class에든 값이 저장될 때까지 기다린다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int PriorityRingBuffer::getFromNotEmptyBuffer() noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        _notEmpty.wait(lock, [this]() { return _nonEmpty != 0; });
+
+        size_t priority = select();
+        int item = pop(priority);
+        /* Critical section end */
+
+        lock.unlock();
+        _pNotFull[priority].notify_one();
+
+        return item;
+    }
+
+}; // rtos
@@ -0,0 +1,76 @@
+/**
+ * @file priorityringbuffer.h
+ * @brief Set of per-priority rings with bitmask selection and starvation protection
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _PRIORITY_RING_BUFFER_H_
+#define _PRIORITY_RING_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    const size_t MAX_PRIORITY_CLASSES = 32; // 비어 있지 않은 class를 uint32_t bitmask로 관리한다.
+
+
+    /**
+     * @brief 우선순위 class마다 ring을 하나씩 두는 RingBuffer. 0이 가장 높은 우선순위이다.
+     *
+     * 같은 class 안에서는 FIFO이며, get은 비어 있지 않은 class 중 가장 높은 class에서 꺼낸다.
+     * 비어 있지 않은 class를 bitmask로 관리하므로 선택은 ctz 한 번이다.
+     *
+     * starvationLimit이 0이 아니면, 비어 있지 않은데 더 높은 class에 밀려 starvationLimit번 연속으로
+     * 건너뛴 class는 다음 get에서 먼저 꺼낸다. 따라서 낮은 class도 일정 비율 이상 처리된다.
+     *
+     * 모든 class가 하나의 mutex와 하나의 not-empty condition variable을 공유하므로
+     * getFromNotEmptyBuffer는 어느 class에 저장되어도 깨어난다.
+     */
+    class PriorityRingBuffer {
+
+        private:
+            int* _pBuffer; // class i의 slot은 [i * BUFFER_SIZE, (i + 1) * BUFFER_SIZE)
+            const size_t CLASS_NUM;
+            const size_t BUFFER_SIZE; // class 하나의 크기
+            const size_t STARVATION_LIMIT;
+            size_t* _pFront; // class마다 지금까지 저장된 데이터 개수
+            size_t* _pBack; // class마다 지금까지 꺼낸 데이터 개수
+            size_t* _pBypassed; // class마다 연속으로 건너뛴 횟수
+            uint32_t _nonEmpty; // 비어 있지 않은 class의 bitmask
+            uint32_t _starving; // 건너뛴 횟수가 STARVATION_LIMIT에 도달한 class의 bitmask
+            mutex _mutex;
+            condition_variable _notEmpty; // 모든 class가 공유한다.
+            condition_variable* _pNotFull; // class마다 하나
+
+            bool isFull(size_t priority) const noexcept;
+            void push(size_t priority, int item) noexcept;
+            size_t select() noexcept;
+            int pop(size_t priority) noexcept;
+
+        public:
+            PriorityRingBuffer(size_t classes, size_t n, size_t starvationLimit = 0);
+            ~PriorityRingBuffer();
+
+            PriorityRingBuffer(const PriorityRingBuffer&) = delete;
+            PriorityRingBuffer& operator=(const PriorityRingBuffer&) = delete;
+
+            void put (size_t priority, int item) noexcept;
+            void putWithoutOverride (size_t priority, int item) noexcept;
+            int get();
+            int getFromNotEmptyBuffer () noexcept;
+
+            bool tryGet (int& item, size_t& priority) noexcept;
+
+    }; // PriorityRingBuffer
+
+}; // rtos
+
+#endif // _PRIORITY_RING_BUFFER_H_
@@ -0,0 +1,299 @@
+/**
+ * @file recordringbuffer.cpp
+ * @brief Byte-oriented ring of variable-length records over mirrored virtual memory
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "recordringbuffer.h"
+
+
+namespace rtos {
+
+    const size_t RECORD_ALIGNMENT = 8; // record의 시작 위치 정렬 단위
+
+
+    /**
+     * @brief Default Constructor which creates a buffer of one page.
+     */
+    RecordRingBuffer::RecordRingBuffer(): RecordRingBuffer(1) {
+    }
+
+
+    /**
+     * @brief Creates a ring buffer of at least n bytes. 크기는 page 크기의 배수로 올림된다.
+     * mapping에 실패하면 StorageException을 던진다.
+     *
+     * @param n Buffer size in bytes.
+     */
+    RecordRingBuffer::RecordRingBuffer(size_t n) {
+
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        BUFFER_SIZE = max(page, (n + page - 1) / page * page);
+        _front = 0;
+        _back = 0;
+
+        int fd = memfd_create("rtos::RecordRingBuffer", MFD_CLOEXEC);
+        if (fd < 0)
+            throw StorageException(string("memfd_create: ") + strerror(errno));
+
+        if (ftruncate(fd, BUFFER_SIZE) < 0) {
+            string message = string("ftruncate: ") + strerror(errno);
+            close(fd);
+            throw StorageException(message);
+        }
+
+        // 주소 공간을 두 배로 확보한 뒤 같은 파일을 앞뒤에 겹쳐 mapping한다.
+        void* base = mmap(nullptr, 2 * BUFFER_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            string message = string("mmap: ") + strerror(errno);
+            close(fd);
+            throw StorageException(message);
+        }
+
+        _pBuffer = static_cast<char*>(base);
+        if (mmap(_pBuffer, BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+            || mmap(_pBuffer + BUFFER_SIZE, BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            string message = string("mmap: ") + strerror(errno);
+            munmap(base, 2 * BUFFER_SIZE);
+            close(fd);
+            throw StorageException(message);
+        }
+
+        close(fd);
+    }
+
+
+    RecordRingBuffer::~RecordRingBuffer() {
+        munmap(_pBuffer, 2 * BUFFER_SIZE);
+    }
+
+
+    /**
+     * @brief 저장할 수 있는 byte 수. record마다 길이와 정렬을 위한 공간이 추가로 필요하다.
+     */
+    size_t RecordRingBuffer::capacity() const noexcept {
+        return BUFFER_SIZE;
+    }
+
+
+    /**
+     * @brief 길이 length인 record가 버퍼에서 차지하는 byte 수.
+     */
+    size_t RecordRingBuffer::recordSize(size_t length) noexcept {
+        return (sizeof(uint32_t) + length + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+    }
+
+
+    bool RecordRingBuffer::isEmpty() const noexcept {
+        return _front == _back;
+    }
+
+
+    /**
+     * @brief 길이 length인 record를 저장할 공간이 있으면 true. _mutex를 잡은 상태에서 호출한다.
+     */
+    bool RecordRingBuffer::fits(size_t length) const noexcept {
+        return BUFFER_SIZE - (_front - _back) >= recordSize(length);
+    }
+
+
+    /**
+     * @brief record 하나를 _front에 쓴다. _mutex를 잡은 상태에서 호출한다.
+     * mirror mapping 덕분에 버퍼 끝을 넘어가도 memcpy 한 번으로 쓸 수 있다.
+     */
+    void RecordRingBuffer::write(const void* data, size_t length) noexcept {
+
+        char* p = _pBuffer + _front % BUFFER_SIZE;
+        uint32_t header = (uint32_t)length;
+
+        memcpy(p, &header, sizeof(header));
+        memcpy(p + sizeof(header), data, length);
+        _front += recordSize(length);
+    }
+
+
+    /**
+     * @brief _back의 record를 data에 복사하고 꺼낸다. _mutex를 잡은 상태에서 호출한다.
+     *
+     * @return record의 길이.
+     */
+    size_t RecordRingBuffer::read(void* data, size_t length) noexcept {
+
+        const char* p = _pBuffer + _back % BUFFER_SIZE;
+        uint32_t header;
+
+        memcpy(&header, p, sizeof(header));
+        memcpy(data, p + sizeof(header), min(length, (size_t)header));
+        _back += recordSize(header);
+
+        return header;
+    }
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 없으면 record를 쓰지 않는다.
+     *
+     * @param data 저장할 record
+     * @param length record의 byte 수
+     *
+     * @return 저장했으면 true, 빈 공간이 부족하거나 길이가 UINT32_MAX보다 길면 false.
+     */
+    bool RecordRingBuffer::put(const void* data, size_t length) noexcept {
+
+        // header에는 길이를 32 bit로 저장하며, 너무 긴 length는 recordSize에서 넘칠 수 있다.
+        if (length > UINT32_MAX)
+            return false;
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        bool stored = fits(length);
+        if (stored)
+            write(data, length);
+        /* Critical section end */
+
+        lock.unlock();
+        if (stored)
+            _notEmpty.notify_one();
+
+        return stored;
+    }
+
+
+    /**
+     * @brief record를 덮어쓰지 않고 빈 공간이 생길때까지 대기한다.
+     * 버퍼 전체보다 큰 record는 저장할 수 없으므로 기다리지 않고 false를 반환한다.
+     *
+     * @param data 저장할 record
+     * @param length record의 byte 수
+     *
+     * @return 저장했으면 true, 버퍼 전체보다 크거나 길이가 UINT32_MAX보다 길면 false.
+     */
+    bool RecordRingBuffer::putWithoutOverride(const void* data, size_t length) noexcept {
+
+        if (length > UINT32_MAX || recordSize(length) > BUFFER_SIZE)
+            return false;
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        _notFull.wait(lock, [this, length]() { return fits(length); });
+        write(data, length);
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+
+        return true;
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 record를 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+     * record가 length보다 길면 앞의 length byte만 복사한다.
+     *
+     * @param data record를 복사할 공간
+     * @param length data의 byte 수
+     *
+     * @return record의 길이.
+     */
+    size_t RecordRingBuffer::get(void* data, size_t length) {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isEmpty()) {
+            lock.unlock();
+            throw EmptyBufferReadException();
+        }
+
+        size_t recordLength = read(data, length);
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_all();
+
+        return recordLength;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 record가 저장될 때까지 기다린다.
+     *
+     * @param data record를 복사할 공간
+     * @param length data의 byte 수
+     *
+     * @return record의 길이.
+     */
+    size_t RecordRingBuffer::getFromNotEmptyBuffer(void* data, size_t length) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        _notEmpty.wait(lock, [this]() { return !isEmpty(); });
+        size_t recordLength = read(data, length);
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_all();
+
+        return recordLength;
+    }
+
+
+    /**
+     * @brief 가장 오래된 record를 꺼내지 않고 그 자리에서 읽는다. 버퍼 끝을 넘어가는 record도 연속된 주소로 보인다.
+     * 반환된 주소는 release를 호출할 때까지 유효하다.
+     *
+     * @param length record의 길이를 저장할 변수
+     *
+     * @return record의 시작 주소. 버퍼가 비어 있으면 nullptr.
+     */
+    const void* RecordRingBuffer::peek(size_t& length) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isEmpty())
+            return nullptr;
+
+        const char* p = _pBuffer + _back % BUFFER_SIZE;
+        uint32_t header;
+        memcpy(&header, p, sizeof(header));
+        /* Critical section end */
+
+        length = header;
+
+        return p + sizeof(header);
+    }
+
+
+    /**
+     * @brief peek로 읽은 record를 꺼낸 것으로 처리한다.
+     */
+    void RecordRingBuffer::release() noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isEmpty())
+            return;
+
+        uint32_t header;
+        memcpy(&header, _pBuffer + _back % BUFFER_SIZE, sizeof(header));
+        _back += recordSize(header);
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_all();
+    }
+
+}; // rtos
@@ -0,0 +1,72 @@
+/**
+ * @file recordringbuffer.h
+ * @brief Byte-oriented ring of variable-length records over mirrored virtual memory
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _RECORD_RING_BUFFER_H_
+#define _RECORD_RING_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+
+#include "ringbuffer.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 길이가 서로 다른 record를 저장하는 byte 단위 RingBuffer.
+     *
+     * 저장 공간을 가상 메모리에 두 번 연속으로 mapping하므로(memfd + mmap) 버퍼 끝을 넘어가는
+     * record도 하나의 연속된 주소 범위로 읽고 쓸 수 있다. 각 record는 길이(4 byte) 뒤에
+     * 내용이 오며 8 byte 단위로 정렬된다. 용량은 page 크기의 배수로 올림된다.
+     *
+     * put 계열은 record 하나를 memcpy 한 번으로 저장하고, consumer는 peek/release로
+     * 복사 없이 record를 그 자리에서 처리할 수 있다. peek/release는 consumer가 하나일 때 사용한다.
+     */
+    class RecordRingBuffer {
+
+        private:
+            char* _pBuffer; // 같은 물리 메모리가 [0, BUFFER_SIZE)와 [BUFFER_SIZE, 2 * BUFFER_SIZE)에 보인다.
+            size_t BUFFER_SIZE;
+            size_t _front; // 지금까지 저장된 byte 수
+            size_t _back; // 지금까지 꺼낸 byte 수
+            mutex _mutex;
+            condition_variable _notEmpty;
+            condition_variable _notFull;
+
+            static size_t recordSize(size_t length) noexcept;
+            bool isEmpty() const noexcept;
+            bool fits(size_t length) const noexcept;
+            void write(const void* data, size_t length) noexcept;
+            size_t read(void* data, size_t length) noexcept;
+
+        public:
+            RecordRingBuffer();
+            RecordRingBuffer(size_t n);
+            ~RecordRingBuffer();
+
+            RecordRingBuffer(const RecordRingBuffer&) = delete;
+            RecordRingBuffer& operator=(const RecordRingBuffer&) = delete;
+
+            size_t capacity() const noexcept;
+
+            bool put (const void* data, size_t length) noexcept;
+            bool putWithoutOverride (const void* data, size_t length) noexcept;
+            size_t get (void* data, size_t length);
+            size_t getFromNotEmptyBuffer (void* data, size_t length) noexcept;
+
+            const void* peek (size_t& length) noexcept;
+            void release () noexcept;
+
+    }; // RecordRingBuffer
+
+}; // rtos
+
+#endif // _RECORD_RING_BUFFER_H_
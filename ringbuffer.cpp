@@ -6,20 +6,85 @@
  */
 
 
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <thread>
+#include <new>
+#ifdef __linux__
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#endif
+
 #include "ringbuffer.h"
 
 
 namespace rtos {
 
+    const int SPIN_LIMIT = 128; // SPIN_YIELD, SPIN_PARK에서 yield/park 전에 spin하는 횟수
+    const chrono::steady_clock::time_point NO_DEADLINE = chrono::steady_clock::time_point::max();
+
+
+    /**
+     * @brief spin 중에 CPU에게 대기 중임을 알린다. (x86 pause, ARM yield)
+     */
+    static inline void cpuRelax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+
+    /**
+     * @brief *pWord가 여전히 expected인 경우 값이 바뀌어 깨워지거나 deadline이 될 때까지 잠든다.
+     */
+    static inline void futexWait(atomic<uint32_t>* pWord, uint32_t expected,
+        const chrono::steady_clock::time_point& deadline) noexcept {
+#ifdef __linux__
+        struct timespec timeout;
+        struct timespec* pTimeout = nullptr;
+        if (deadline != NO_DEADLINE) {
+            auto remaining = chrono::duration_cast<chrono::nanoseconds>(deadline - chrono::steady_clock::now());
+            if (remaining.count() <= 0)
+                return;
+            timeout.tv_sec = remaining.count() / 1000000000;
+            timeout.tv_nsec = remaining.count() % 1000000000;
+            pTimeout = &timeout;
+        }
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAIT_PRIVATE, expected, pTimeout, nullptr, 0);
+#else
+        if (pWord->load() == expected)
+            this_thread::yield();
+#endif
+    }
+
+
+    /**
+     * @brief futexWait으로 잠든 쓰레드를 깨운다.
+     */
+    static inline void futexWake(atomic<uint32_t>* pWord, bool all) noexcept {
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#endif
+    }
+
+
+    /**
+     * @brief 지연 추적에 사용하는 단조 증가 시각(ns). Linux에서는 vDSO로 읽으므로 system call이 없다.
+     */
+    static inline uint64_t monotonicNanos() noexcept {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
 
     /**
      * @brief Default Constructor which creates a buffer of length 10.
      */
-    RingBuffer::RingBuffer(): BUFFER_SIZE(10) {
-        _pBuffer = new int[10];
-        _front = 0;
-        _back = 0;
-        _isFull = false;
+    RingBuffer::RingBuffer(): RingBuffer(10) {
     }
 
 
@@ -28,16 +93,298 @@ namespace rtos {
      *
      * @param n Buffer size.
      */
-    RingBuffer::RingBuffer(size_t n): BUFFER_SIZE(n) {
-        _pBuffer = new int[BUFFER_SIZE];
+    RingBuffer::RingBuffer(size_t n): RingBuffer(n, WaitStrategy::BLOCK) {
+    }
+
+
+    /**
+     * @brief Creates a ring buffer of length n which waits with the given strategy.
+     *
+     * @param n Buffer size.
+     * @param strategy putWithoutOverride, getFromNotEmptyBuffer가 기다리는 방법.
+     */
+    RingBuffer::RingBuffer(size_t n, WaitStrategy strategy): RingBuffer(n, strategy, StorageOptions()) {
+    }
+
+
+    /**
+     * @brief Creates a ring buffer of length n whose slots are allocated as described by options.
+     * options를 적용하지 못하면 StorageException을 던진다.
+     *
+     * @param n Buffer size.
+     * @param strategy putWithoutOverride, getFromNotEmptyBuffer가 기다리는 방법.
+     * @param options 저장 공간의 정렬, huge page, NUMA node, prefault, mlock, allocator
+     */
+    RingBuffer::RingBuffer(size_t n, WaitStrategy strategy, const StorageOptions& options):
+        BUFFER_SIZE(n), _storage(n * sizeof(int), options), _waitStrategy(strategy) {
+        _pBuffer = static_cast<int*>(_storage.data());
         _front = 0;
         _back = 0;
         _isFull = false;
+        _putEpoch.store(0);
+        _getEpoch.store(0);
+        _notEmptyWaiters.store(0);
+        _notFullWaiters.store(0);
+        _enqueues.store(0);
+        _dequeues.store(0);
+        _droppedPuts.store(0);
+        _emptyReads.store(0);
+        _highWaterMark.store(0);
+        _putBlockedNanos.store(0);
+        _getBlockedNanos.store(0);
+        _lockContentions.store(0);
+        _notEmptyFd = -1;
+        _notFullFd = -1;
+        _pStamps = nullptr;
+        _sampleInterval = 1;
+        _sampleCounter = 0;
     }
 
 
     RingBuffer::~RingBuffer() {
-        delete [] _pBuffer;
+        delete [] _pStamps;
+#ifdef __linux__
+        if (_notEmptyFd >= 0) {
+            close(_notEmptyFd);
+            close(_notFullFd);
+        }
+#endif
+    }
+
+
+    /**
+     * @brief _mutex를 잡는다. 다른 쓰레드가 이미 잡고 있으면 lock contention으로 기록한다.
+     */
+    unique_lock<mutex> RingBuffer::acquire() noexcept {
+
+        unique_lock<mutex> lock(_mutex, try_to_lock);
+
+        if (!lock.owns_lock()) {
+            _lockContentions.fetch_add(1, memory_order_relaxed);
+            lock.lock();
+        }
+
+        return lock;
+    }
+
+
+    /**
+     * @brief 현재 저장된 데이터 개수로 high-water mark를 갱신한다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    void RingBuffer::recordOccupancy() noexcept {
+
+        uint64_t occupancy = count();
+
+        if (occupancy > _highWaterMark.load(memory_order_relaxed))
+            _highWaterMark.store(occupancy, memory_order_relaxed);
+    }
+
+
+    /**
+     * @brief notEmptyFd, notFullFd를 만들고 현재 상태로 초기화한다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    void RingBuffer::openReadinessFds() noexcept {
+#ifdef __linux__
+        if (_notEmptyFd >= 0)
+            return;
+
+        int notEmpty = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        int notFull = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (notEmpty < 0 || notFull < 0) {
+            if (notEmpty >= 0)
+                close(notEmpty);
+            if (notFull >= 0)
+                close(notFull);
+            return;
+        }
+
+        _notEmptyFd = notEmpty;
+        _notFullFd = notFull;
+        if (count() > 0)
+            eventfd_write(_notEmptyFd, 1);
+        if (!_isFull)
+            eventfd_write(_notFullFd, 1);
+#endif
+    }
+
+
+    /**
+     * @brief 비어 있음, 가득 참 상태가 바뀐 경우에만 eventfd를 갱신한다. _mutex를 잡은 상태에서 호출해야 한다.
+     * 조건이 참이 되면 값을 써서 readable로 만들고, 거짓이 되면 값을 읽어 비운다.
+     * 그 외의 put/get에서는 system call을 하지 않는다.
+     *
+     * @param wasEmpty 변경 전에 버퍼가 비어 있었는지
+     * @param wasFull 변경 전에 버퍼가 가득 차 있었는지
+     */
+    void RingBuffer::updateReadiness(bool wasEmpty, bool wasFull) noexcept {
+#ifdef __linux__
+        if (_notEmptyFd < 0)
+            return;
+
+        eventfd_t value;
+        bool isEmpty = (_front == _back) && !_isFull;
+
+        if (wasEmpty && !isEmpty)
+            eventfd_write(_notEmptyFd, 1);
+        else if (!wasEmpty && isEmpty)
+            eventfd_read(_notEmptyFd, &value);
+
+        if (wasFull && !_isFull)
+            eventfd_write(_notFullFd, 1);
+        else if (!wasFull && _isFull)
+            eventfd_read(_notFullFd, &value);
+#endif
+    }
+
+
+    /**
+     * @brief index부터 n개 slot에 저장 시각을 기록한다. _sampleInterval개 중 하나만 표본으로 기록하고
+     * 나머지는 0으로 둔다. 지연 추적이 꺼져 있으면 아무것도 하지 않는다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    void RingBuffer::stamp(size_t index, size_t n) noexcept {
+
+        if (_pStamps == nullptr)
+            return;
+
+        uint64_t now = 0;
+        for (size_t i=0; i<n; ++i) {
+            uint64_t value = 0;
+            if (++_sampleCounter >= _sampleInterval) {
+                _sampleCounter = 0;
+                if (now == 0)
+                    now = monotonicNanos();
+                value = now;
+            }
+            _pStamps[(index + i) % BUFFER_SIZE] = value;
+        }
+    }
+
+
+    /**
+     * @brief index부터 n개 slot 중 표본의 버퍼 체류 시간을 _latency에 기록한다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    void RingBuffer::trace(size_t index, size_t n) noexcept {
+
+        if (_pStamps == nullptr)
+            return;
+
+        uint64_t now = 0;
+        for (size_t i=0; i<n; ++i) {
+            uint64_t stamped = _pStamps[(index + i) % BUFFER_SIZE];
+            if (stamped == 0)
+                continue;
+            if (now == 0)
+                now = monotonicNanos();
+            _latency.record(now > stamped ? now - stamped : 0);
+        }
+    }
+
+
+    /**
+     * @brief ready()가 true가 되거나 deadline이 될 때까지 _waitStrategy에 따라 기다린다.
+     * lock을 잡은 상태에서 호출하며, 반환할 때도 lock을 잡은 상태이다.
+     *
+     * @param ready 기다리는 조건
+     * @param cond BLOCK에서 잠들 condition variable
+     * @param epoch 조건이 바뀔 때마다 상대방이 증가시키는 값
+     * @param waiters 잠들어 있는 쓰레드 수. 상대방은 이 값이 0이면 깨우지 않는다.
+     * @param blockedNanos 실제로 기다린 시간을 더할 지표
+     * @param deadline 기다릴 수 있는 마지막 시각. NO_DEADLINE이면 계속 기다린다.
+     *
+     * @return ready()가 true가 되었으면 true, 시간이 초과되었으면 false.
+     */
+    template <typename Predicate>
+    bool RingBuffer::wait(unique_lock<mutex>& lock, Predicate ready,
+        condition_variable& cond, atomic<uint32_t>& epoch, atomic<uint32_t>& waiters,
+        atomic<uint64_t>& blockedNanos, const chrono::steady_clock::time_point& deadline) {
+
+        // 기다리지 않는 경우에는 시간을 읽지 않는다.
+        if (ready())
+            return true;
+
+        bool timed = (deadline != NO_DEADLINE);
+        auto start = chrono::steady_clock::now();
+        bool result = true;
+
+        if (_waitStrategy == WaitStrategy::BLOCK) {
+            while (!ready()) {
+                waiters.fetch_add(1);
+                bool timeout = false;
+                if (timed)
+                    timeout = (cond.wait_until(lock, deadline) == cv_status::timeout);
+                else
+                    cond.wait(lock);
+                waiters.fetch_sub(1);
+                if (timeout) {
+                    result = ready();
+                    break;
+                }
+            }
+        }
+        else {
+            while (!ready()) {
+                if (timed && chrono::steady_clock::now() >= deadline) {
+                    result = false;
+                    break;
+                }
+
+                // lock을 잡은 상태에서 읽었으므로 이후의 변경은 모두 epoch을 바꾼다.
+                uint32_t seen = epoch.load();
+                lock.unlock();
+
+                int spin = 0;
+                while (epoch.load(memory_order_acquire) == seen) {
+                    if (timed && chrono::steady_clock::now() >= deadline)
+                        break;
+                    if (_waitStrategy == WaitStrategy::BUSY_SPIN)
+                        continue;
+                    if (spin < SPIN_LIMIT) {
+                        ++spin;
+                        cpuRelax();
+                    }
+                    else if (_waitStrategy == WaitStrategy::SPIN_YIELD) {
+                        this_thread::yield();
+                    }
+                    else {
+                        waiters.fetch_add(1);
+                        futexWait(&epoch, seen, deadline);
+                        waiters.fetch_sub(1);
+                    }
+                }
+
+                lock.lock();
+            }
+        }
+
+        blockedNanos.fetch_add(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count(),
+            memory_order_relaxed);
+
+        return result;
+    }
+
+
+    /**
+     * @brief 상태 변화를 알린다. 잠들어 있는 쓰레드가 있을 때만 깨운다. lock을 놓은 뒤 호출한다.
+     *
+     * @param all true이면 잠든 쓰레드를 모두 깨운다.
+     */
+    void RingBuffer::signal(condition_variable& cond, atomic<uint32_t>& epoch,
+        atomic<uint32_t>& waiters, bool all) noexcept {
+
+        if (_waitStrategy == WaitStrategy::BLOCK) {
+            if (waiters.load() == 0)
+                return;
+            if (all)
+                cond.notify_all();
+            else
+                cond.notify_one();
+            return;
+        }
+
+        epoch.fetch_add(1);
+        if (_waitStrategy == WaitStrategy::SPIN_PARK && waiters.load() > 0)
+            futexWake(&epoch, all);
     }
 
 
@@ -47,18 +394,44 @@ namespace rtos {
      * @param item 버퍼에 저장할 새로운 데이터.
      */
     void RingBuffer::put(int item) noexcept {
+        tryPut(item);
+    }
 
-        unique_lock<mutex> lock(_mutex);
+
+
+    /**
+     * @brief put()과 같지만 저장 여부를 반환한다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     *
+     * @return 저장했으면 true, 버퍼에 빈 공간이 없으면 false.
+     */
+    bool RingBuffer::tryPut(int item) noexcept {
+
+        unique_lock<mutex> lock = acquire();
 
         /* Ciritcal section start */
-        if (!_isFull) {
+        bool stored = !_isFull;
+        if (stored) {
+            bool wasEmpty = (_front == _back);
             _pBuffer[_front] = item;
+            stamp(_front, 1);
             _front = (_front + 1) % BUFFER_SIZE;
             _isFull = (_front == _back);
+            _enqueues.fetch_add(1, memory_order_relaxed);
+            recordOccupancy();
+            updateReadiness(wasEmpty, false);
+        }
+        else {
+            _droppedPuts.fetch_add(1, memory_order_relaxed);
         }
          /* ciritcal section end */
 
         lock.unlock();
+        if (stored)
+            signal(_notEmpty, _putEpoch, _notEmptyWaiters, false);
+
+        return stored;
     }
 
 
@@ -69,19 +442,45 @@ namespace rtos {
      * @param item 버퍼에 저장할 데이터.
      */
     void RingBuffer::putWithoutOverride(int item) noexcept {
+        putUntil(item, NO_DEADLINE);
+    }
+
 
-        unique_lock<mutex> lock(_mutex);
+
+    /**
+     * @brief 데이터를 덮어쓰지 않고 빈 공간이 생기거나 deadline이 될 때까지 대기한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     * @param deadline 기다릴 수 있는 마지막 시각.
+     *
+     * @return 저장했으면 true, 시간이 초과되었으면 false.
+     */
+    bool RingBuffer::putUntil(int item, const chrono::steady_clock::time_point& deadline) noexcept {
+
+        unique_lock<mutex> lock = acquire();
 
         /* Ciritcal section start */
-        _notFull.wait(lock, [this]() { return !_isFull; }); // 버퍼에 공간이 생길 때까지 기다린다.
+        // 버퍼에 공간이 생길 때까지 기다린다.
+        if (!wait(lock, [this]() { return !_isFull; },
+                _notFull, _getEpoch, _notFullWaiters, _putBlockedNanos, deadline)) {
+            _droppedPuts.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
 
+        bool wasEmpty = (_front == _back);
         _pBuffer[_front] = item;
+        stamp(_front, 1);
         _front = (_front + 1) % BUFFER_SIZE;
         _isFull = (_front == _back);
+        _enqueues.fetch_add(1, memory_order_relaxed);
+        recordOccupancy();
+        updateReadiness(wasEmpty, false);
          /* ciritcal section end */
 
         lock.unlock();
-        _notEmpty.notify_one();
+        signal(_notEmpty, _putEpoch, _notEmptyWaiters, false);
+
+        return true;
     }
 
 
@@ -93,23 +492,47 @@ namespace rtos {
      */
     int RingBuffer::get() {
 
-        unique_lock<mutex> lock(_mutex);
+        int item;
+
+        if (!tryGet(item))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+
+    /**
+     * @brief get()과 같지만 버퍼가 비어 있으면 예외 대신 false를 반환한다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼냈으면 true, 버퍼가 비어 있으면 false.
+     */
+    bool RingBuffer::tryGet(int& item) noexcept {
+
+        unique_lock<mutex> lock = acquire();
 
         /* Critical section start */
         if ( (_front == _back) && !_isFull ) {
-            lock.unlock();
-            throw EmptyBufferReadException();
+            _emptyReads.fetch_add(1, memory_order_relaxed);
+            return false;
         }
 
-        int item = _pBuffer[_back];
+        bool wasFull = _isFull;
+        item = _pBuffer[_back];
+        trace(_back, 1);
         _back = (_back + 1) % BUFFER_SIZE;
         _isFull = false;
+        _dequeues.fetch_add(1, memory_order_relaxed);
+        updateReadiness(false, wasFull);
 
         lock.unlock();
+        signal(_notFull, _getEpoch, _notFullWaiters, false);
 
         /* Critical section end */
 
-        return item;
+        return true;
     }
 
 
@@ -121,24 +544,347 @@ namespace rtos {
      */
     int RingBuffer::getFromNotEmptyBuffer() noexcept {
 
-        unique_lock<mutex> lock(_mutex);
+        int item;
+        getUntil(item, NO_DEADLINE);
+
+        return item;
+    }
+
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장되거나 deadline이 될 때까지 기다린다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     * @param deadline 기다릴 수 있는 마지막 시각.
+     *
+     * @return 꺼냈으면 true, 시간이 초과되었으면 false.
+     */
+    bool RingBuffer::getUntil(int& item, const chrono::steady_clock::time_point& deadline) noexcept {
+
+        unique_lock<mutex> lock = acquire();
 
         /* Critical section start */
         /*
          * 버퍼가 비어있는 동안 대기한다.
          * (_front == _back) && !_isFull 인 동안 대기한다.*/
-        _notEmpty.wait(lock,
-            [this]() { return (_front != _back) || _isFull; }); 
-        int item = _pBuffer[_back];
+        if (!wait(lock, [this]() { return (_front != _back) || _isFull; },
+                _notEmpty, _putEpoch, _notEmptyWaiters, _getBlockedNanos, deadline)) {
+            _emptyReads.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+
+        bool wasFull = _isFull;
+        item = _pBuffer[_back];
+        trace(_back, 1);
         _back = (_back + 1) % BUFFER_SIZE;
         _isFull = false;
+        _dequeues.fetch_add(1, memory_order_relaxed);
+        updateReadiness(false, wasFull);
 
         lock.unlock();
-        _notFull.notify_one();
+        signal(_notFull, _getEpoch, _notFullWaiters, false);
 
         /* Critical section end */
 
-        return item;
+        return true;
     }
-        
+
+
+
+    /**
+     * @brief 버퍼에 저장된 데이터 개수. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    size_t RingBuffer::count() const noexcept {
+        if (_isFull)
+            return BUFFER_SIZE;
+        return (_front + BUFFER_SIZE - _back) % BUFFER_SIZE;
+    }
+
+
+
+    /**
+     * @brief 빈 공간만큼 items를 저장한다. _mutex를 잡은 상태에서 호출해야 한다.
+     * 끝에서 처음으로 넘어가는 경우에도 memcpy는 최대 두 번이다.
+     *
+     * @return 저장한 데이터 개수.
+     */
+    size_t RingBuffer::pushN(const int* items, size_t n) noexcept {
+
+        n = min(n, BUFFER_SIZE - count());
+        if (n == 0)
+            return 0;
+
+        bool wasEmpty = (_front == _back);
+        size_t first = min(n, BUFFER_SIZE - _front);
+        memcpy(_pBuffer + _front, items, first * sizeof(int));
+        memcpy(_pBuffer, items + first, (n - first) * sizeof(int));
+
+        stamp(_front, n);
+        _front = (_front + n) % BUFFER_SIZE;
+        _isFull = (_front == _back);
+        _enqueues.fetch_add(n, memory_order_relaxed);
+        recordOccupancy();
+        updateReadiness(wasEmpty, false);
+
+        return n;
+    }
+
+
+
+    /**
+     * @brief 저장된 데이터를 최대 n개 꺼낸다. _mutex를 잡은 상태에서 호출해야 한다.
+     *
+     * @return 꺼낸 데이터 개수.
+     */
+    size_t RingBuffer::popN(int* items, size_t n) noexcept {
+
+        n = min(n, count());
+        if (n == 0)
+            return 0;
+
+        bool wasFull = _isFull;
+        size_t first = min(n, BUFFER_SIZE - _back);
+        memcpy(items, _pBuffer + _back, first * sizeof(int));
+        memcpy(items + first, _pBuffer, (n - first) * sizeof(int));
+
+        trace(_back, n);
+        _back = (_back + n) % BUFFER_SIZE;
+        _isFull = false;
+        _dequeues.fetch_add(n, memory_order_relaxed);
+        updateReadiness(false, wasFull);
+
+        return n;
+    }
+
+
+
+    /**
+     * @brief 빈 공간이 있는 만큼 items를 한 번에 저장하고 나머지는 버린다.
+     *
+     * @param items 버퍼에 저장할 데이터 배열.
+     * @param n 배열의 길이.
+     *
+     * @return 저장한 데이터 개수.
+     */
+    size_t RingBuffer::putN(const int* items, size_t n) noexcept {
+
+        unique_lock<mutex> lock = acquire();
+
+        /* Critical section start */
+        size_t stored = pushN(items, n);
+        _droppedPuts.fetch_add(n - stored, memory_order_relaxed);
+        /* Critical section end */
+
+        lock.unlock();
+        if (stored > 0)
+            signal(_notEmpty, _putEpoch, _notEmptyWaiters, true);
+
+        return stored;
+    }
+
+
+
+    /**
+     * @brief 빈 공간이 생길 때까지 기다린 뒤 빈 공간만큼 items를 한 번에 저장한다.
+     * 남은 데이터는 저장하지 않으므로 반환값을 보고 다시 호출해야 한다.
+     *
+     * @param items 버퍼에 저장할 데이터 배열.
+     * @param n 배열의 길이.
+     *
+     * @return 저장한 데이터 개수.
+     */
+    size_t RingBuffer::putNWithoutOverride(const int* items, size_t n) noexcept {
+
+        if (n == 0)
+            return 0;
+
+        unique_lock<mutex> lock = acquire();
+
+        /* Critical section start */
+        wait(lock, [this]() { return !_isFull; },
+            _notFull, _getEpoch, _notFullWaiters, _putBlockedNanos, NO_DEADLINE);
+        size_t stored = pushN(items, n);
+        /* Critical section end */
+
+        lock.unlock();
+        signal(_notEmpty, _putEpoch, _notEmptyWaiters, true);
+
+        return stored;
+    }
+
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 최대 n개의 값을 한 번에 꺼낸다. get()과 달리 버퍼가 비어 있으면 0을 반환한다.
+     *
+     * @param items 꺼낸 데이터를 저장할 배열.
+     * @param n 배열의 길이.
+     *
+     * @return 꺼낸 데이터 개수.
+     */
+    size_t RingBuffer::getN(int* items, size_t n) noexcept {
+
+        unique_lock<mutex> lock = acquire();
+
+        /* Critical section start */
+        size_t taken = popN(items, n);
+        if (taken == 0)
+            _emptyReads.fetch_add(1, memory_order_relaxed);
+        /* Critical section end */
+
+        lock.unlock();
+        if (taken > 0)
+            signal(_notFull, _getEpoch, _notFullWaiters, true);
+
+        return taken;
+    }
+
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린 뒤 최대 n개의 값을 한 번에 꺼낸다.
+     *
+     * @param items 꺼낸 데이터를 저장할 배열.
+     * @param n 배열의 길이.
+     *
+     * @return 꺼낸 데이터 개수.
+     */
+    size_t RingBuffer::getNFromNotEmptyBuffer(int* items, size_t n) noexcept {
+
+        if (n == 0)
+            return 0;
+
+        unique_lock<mutex> lock = acquire();
+
+        /* Critical section start */
+        wait(lock, [this]() { return (_front != _back) || _isFull; },
+            _notEmpty, _putEpoch, _notEmptyWaiters, _getBlockedNanos, NO_DEADLINE);
+        size_t taken = popN(items, n);
+        /* Critical section end */
+
+        lock.unlock();
+        signal(_notFull, _getEpoch, _notFullWaiters, true);
+
+        return taken;
+    }
+
+
+
+    /**
+     * @brief 가장 최근에 저장된 n개의 합, 최솟값, 최댓값, threshold를 넘은 개수와 횟수를 데이터를 꺼내지 않고 계산한다.
+     * 버퍼의 저장 공간에서 직접 SIMD kernel(accumulateWindow)을 실행하며, 그동안 lock을 잡는다.
+     *
+     * @param n 집계할 최근 데이터 개수. 저장된 개수보다 크면 전부 집계한다.
+     * @param threshold aboveThreshold, crossings의 기준값
+     *
+     * @return 집계 결과. 평균은 sum / count이다.
+     */
+    WindowAggregate RingBuffer::aggregateWindow(size_t n, int threshold) noexcept {
+
+        WindowAggregate aggregate = emptyWindowAggregate();
+
+        visitWindow(n, [&aggregate, threshold](const int* items, size_t length) {
+            accumulateWindow(items, length, threshold, aggregate);
+        });
+
+        return aggregate;
+    }
+
+
+
+    /**
+     * @brief 지금까지 기록한 지표를 lock 없이 읽는다. 주기적으로 수집하는 용도이며,
+     * 각 값은 따로 읽으므로 동시에 동작 중인 경우 서로 약간 어긋날 수 있다.
+     *
+     * @return 지표의 snapshot
+     */
+    RingBufferStats RingBuffer::stats() const noexcept {
+
+        RingBufferStats snapshot;
+
+        snapshot.enqueues = _enqueues.load(memory_order_relaxed);
+        snapshot.dequeues = _dequeues.load(memory_order_relaxed);
+        snapshot.droppedPuts = _droppedPuts.load(memory_order_relaxed);
+        snapshot.emptyReads = _emptyReads.load(memory_order_relaxed);
+        snapshot.highWaterMark = _highWaterMark.load(memory_order_relaxed);
+        snapshot.putBlockedNanos = _putBlockedNanos.load(memory_order_relaxed);
+        snapshot.getBlockedNanos = _getBlockedNanos.load(memory_order_relaxed);
+        snapshot.lockContentions = _lockContentions.load(memory_order_relaxed);
+
+        return snapshot;
+    }
+
+
+
+    /**
+     * @brief 버퍼가 비어 있지 않은 동안 readable인 eventfd. epoll, poll, select로 기다릴 수 있다.
+     * 처음 호출할 때 notFullFd와 함께 만들어지며 버퍼가 소멸할 때 닫힌다.
+     * 값은 버퍼가 관리하므로 읽지 말고, readable이 되면 tryGet이나 getN으로 꺼낸다.
+     *
+     * @return file descriptor. 만들 수 없으면 -1.
+     */
+    int RingBuffer::notEmptyFd() noexcept {
+
+        unique_lock<mutex> lock = acquire();
+        openReadinessFds();
+
+        return _notEmptyFd;
+    }
+
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 있는 동안 readable인 eventfd. notEmptyFd와 같은 방법으로 사용한다.
+     *
+     * @return file descriptor. 만들 수 없으면 -1.
+     */
+    int RingBuffer::notFullFd() noexcept {
+
+        unique_lock<mutex> lock = acquire();
+        openReadinessFds();
+
+        return _notFullFd;
+    }
+
+
+
+    /**
+     * @brief 데이터가 버퍼에 머문 시간(put부터 get까지)을 latency()에 기록하기 시작한다.
+     * 켜기 전에 저장된 데이터는 기록하지 않는다. 메모리를 할당하지 못하면 꺼진 상태로 남는다.
+     *
+     * @param sampleInterval 저장하는 데이터 sampleInterval개 중 하나만 기록한다. 1이면 모두 기록한다.
+     */
+    void RingBuffer::enableLatencyTracing(size_t sampleInterval) noexcept {
+
+        unique_lock<mutex> lock = acquire();
+
+        if (_pStamps == nullptr)
+            _pStamps = new (nothrow) uint64_t[BUFFER_SIZE]();
+        _sampleInterval = max(sampleInterval, (size_t)1);
+        _sampleCounter = 0;
+    }
+
+
+
+    /**
+     * @brief 지연 추적을 끈다. 지금까지 기록한 latency()는 유지된다.
+     */
+    void RingBuffer::disableLatencyTracing() noexcept {
+
+        unique_lock<mutex> lock = acquire();
+
+        delete [] _pStamps;
+        _pStamps = nullptr;
+    }
+
+
+
+    /**
+     * @brief 버퍼 체류 시간의 histogram. lock 없이 조회하거나 reset할 수 있다.
+     */
+    LatencyHistogram& RingBuffer::latency() noexcept {
+        return _latency;
+    }
+
 }; // rtos
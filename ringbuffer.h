@@ -9,25 +9,77 @@
 #define _RING_BUFFER_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <mutex>
 #include <exception>
-#include <queue>
 #ifdef __linux__
     #include <condition_variable>
 #endif
 
+#include "storage.h"
+#include "latencyhistogram.h"
+#include "windowaggregate.h"
+
 typedef size_t period;
 
 using namespace std;
 
 namespace rtos {
 
+    class RecordRingBuffer;
+
+
+    /**
+     * @brief putWithoutOverride, getFromNotEmptyBuffer가 기다리는 방법.
+     */
+    enum class WaitStrategy {
+        BLOCK,      // condition_variable에서 잠든다. (기본값)
+        BUSY_SPIN,  // 상태가 바뀔 때까지 CPU를 점유하며 확인한다.
+        SPIN_YIELD, // pause 명령과 함께 잠시 spin한 뒤 yield를 반복한다.
+        SPIN_PARK,  // 잠시 spin한 뒤 futex에서 잠든다.
+    };
+
+
+    /**@struct RingBufferStats
+     * @brief RingBuffer가 기록한 지표의 snapshot. 모든 값은 생성된 후의 누적값이다.
+     * @var RingBufferStats::enqueues
+     * 저장한 데이터 개수
+     * @var RingBufferStats::dequeues
+     * 꺼낸 데이터 개수
+     * @var RingBufferStats::droppedPuts
+     * 버퍼가 가득 차서 저장하지 못한 데이터 개수 (put의 no-op, putUntil의 시간 초과 포함)
+     * @var RingBufferStats::emptyReads
+     * 빈 버퍼에서 꺼내려 한 횟수 (get의 예외, getUntil의 시간 초과 포함)
+     * @var RingBufferStats::highWaterMark
+     * 저장된 데이터 개수의 최댓값
+     * @var RingBufferStats::putBlockedNanos
+     * producer가 빈 공간을 기다린 시간의 합(ns)
+     * @var RingBufferStats::getBlockedNanos
+     * consumer가 데이터를 기다린 시간의 합(ns)
+     * @var RingBufferStats::lockContentions
+     * 다른 쓰레드가 lock을 잡고 있어 기다려야 했던 횟수
+     */
+    typedef struct ring_buffer_stats {
+        uint64_t enqueues;
+        uint64_t dequeues;
+        uint64_t droppedPuts;
+        uint64_t emptyReads;
+        uint64_t highWaterMark;
+        uint64_t putBlockedNanos;
+        uint64_t getBlockedNanos;
+        uint64_t lockContentions;
+    } RingBufferStats;
+
+
     class RingBuffer {
 
         private:
-            int* _pBuffer;
             const size_t BUFFER_SIZE;
+            SlotStorage _storage;
+            int* _pBuffer;
             size_t _front;
             size_t _back;
             mutex _mutex;
@@ -35,9 +87,55 @@ namespace rtos {
             condition_variable _notFull; // 버퍼에 빈 공간이 없는 경우 새로운 값이 덮어써지는 것을 방지한다.
             bool _isFull;
 
+            const WaitStrategy _waitStrategy;
+            atomic<uint32_t> _putEpoch; // 데이터가 저장될 때마다 증가한다. (spin, futex용)
+            atomic<uint32_t> _getEpoch; // 데이터를 꺼낼 때마다 증가한다.
+            atomic<uint32_t> _notEmptyWaiters; // 잠들어 있는 consumer 수
+            atomic<uint32_t> _notFullWaiters; // 잠들어 있는 producer 수
+
+            // 지표. 대부분 lock 안에서 갱신하므로 relaxed로 충분하고, stats()는 lock 없이 읽는다.
+            alignas(CACHE_LINE_SIZE) atomic<uint64_t> _enqueues;
+            atomic<uint64_t> _dequeues;
+            atomic<uint64_t> _droppedPuts;
+            atomic<uint64_t> _emptyReads;
+            atomic<uint64_t> _highWaterMark;
+            atomic<uint64_t> _putBlockedNanos;
+            atomic<uint64_t> _getBlockedNanos;
+            atomic<uint64_t> _lockContentions;
+
+            // 상태가 바뀔 때만 쓰는 eventfd. 만들기 전에는 -1이며 _mutex를 잡은 상태에서만 접근한다.
+            int _notEmptyFd;
+            int _notFullFd;
+
+            // 지연 추적. 켜기 전에는 _pStamps가 nullptr이며 _mutex를 잡은 상태에서만 접근한다.
+            uint64_t* _pStamps; // slot별 저장 시각(ns). 표본이 아니면 0
+            size_t _sampleInterval;
+            size_t _sampleCounter;
+            LatencyHistogram _latency;
+
+            unique_lock<mutex> acquire() noexcept;
+            void recordOccupancy() noexcept;
+            void openReadinessFds() noexcept;
+            void updateReadiness(bool wasEmpty, bool wasFull) noexcept;
+            void stamp(size_t index, size_t n) noexcept;
+            void trace(size_t index, size_t n) noexcept;
+
+            template <typename Predicate>
+            bool wait(unique_lock<mutex>& lock, Predicate ready,
+                condition_variable& cond, atomic<uint32_t>& epoch, atomic<uint32_t>& waiters,
+                atomic<uint64_t>& blockedNanos, const chrono::steady_clock::time_point& deadline);
+            void signal(condition_variable& cond, atomic<uint32_t>& epoch,
+                atomic<uint32_t>& waiters, bool all) noexcept;
+
+            size_t count() const noexcept;
+            size_t pushN(const int* items, size_t n) noexcept;
+            size_t popN(int* items, size_t n) noexcept;
+
         public:
             RingBuffer();
             RingBuffer(size_t n);
+            RingBuffer(size_t n, WaitStrategy strategy);
+            RingBuffer(size_t n, WaitStrategy strategy, const StorageOptions& options);
             ~RingBuffer();
 
             void put (int item) noexcept;
@@ -45,6 +143,90 @@ namespace rtos {
             int get();
             int getFromNotEmptyBuffer () noexcept;
 
+            bool tryPut (int item) noexcept;
+            bool tryGet (int& item) noexcept;
+
+            bool putUntil (int item, const chrono::steady_clock::time_point& deadline) noexcept;
+            bool getUntil (int& item, const chrono::steady_clock::time_point& deadline) noexcept;
+
+            /**
+             * @brief putWithoutOverride()와 같지만 timeout 동안만 기다린다.
+             *
+             * @return 저장했으면 true, 시간이 초과되었으면 false.
+             */
+            template <typename Rep, typename Period>
+            bool putFor (int item, const chrono::duration<Rep, Period>& timeout) noexcept {
+                return putUntil(item, chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(timeout));
+            }
+
+            /**
+             * @brief 다른 clock의 deadline을 steady_clock 기준으로 바꾸어 기다린다.
+             */
+            template <typename Clock, typename Duration>
+            bool putUntil (int item, const chrono::time_point<Clock, Duration>& deadline) noexcept {
+                return putFor(item, deadline - Clock::now());
+            }
+
+            /**
+             * @brief getFromNotEmptyBuffer()와 같지만 timeout 동안만 기다린다.
+             *
+             * @return 꺼냈으면 true, 시간이 초과되었으면 false.
+             */
+            template <typename Rep, typename Period>
+            bool getFor (int& item, const chrono::duration<Rep, Period>& timeout) noexcept {
+                return getUntil(item, chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(timeout));
+            }
+
+            template <typename Clock, typename Duration>
+            bool getUntil (int& item, const chrono::time_point<Clock, Duration>& deadline) noexcept {
+                return getFor(item, deadline - Clock::now());
+            }
+
+            size_t putN (const int* items, size_t n) noexcept;
+            size_t putNWithoutOverride (const int* items, size_t n) noexcept;
+            size_t getN (int* items, size_t n) noexcept;
+            size_t getNFromNotEmptyBuffer (int* items, size_t n) noexcept;
+
+            /**
+             * @brief 가장 최근에 저장된 n개(저장된 개수가 적으면 전부)를 꺼내지 않고 복사 없이 visit에게 보여준다.
+             * 끝에서 처음으로 넘어가는 경우 오래된 쪽부터 두 번 호출된다. visit(const int* items, size_t length)는
+             * lock을 잡은 상태에서 호출되므로 짧아야 하며 버퍼에 접근하거나 포인터를 보관하면 안 된다.
+             *
+             * @return 보여준 데이터 개수.
+             */
+            template <typename Visitor>
+            size_t visitWindow (size_t n, Visitor visit) noexcept {
+
+                unique_lock<mutex> lock = acquire();
+
+                /* Critical section start */
+                size_t stored = count();
+                if (n > stored)
+                    n = stored;
+                if (n == 0)
+                    return 0;
+
+                size_t start = (_front + BUFFER_SIZE - n) % BUFFER_SIZE;
+                size_t first = n < BUFFER_SIZE - start ? n : BUFFER_SIZE - start;
+                visit(static_cast<const int*>(_pBuffer + start), first);
+                if (n > first)
+                    visit(static_cast<const int*>(_pBuffer), n - first);
+                /* Critical section end */
+
+                return n;
+            }
+
+            WindowAggregate aggregateWindow (size_t n, int threshold) noexcept;
+
+            RingBufferStats stats() const noexcept;
+
+            int notEmptyFd () noexcept;
+            int notFullFd () noexcept;
+
+            void enableLatencyTracing (size_t sampleInterval = 1) noexcept;
+            void disableLatencyTracing () noexcept;
+            LatencyHistogram& latency () noexcept;
+
     }; // RingBuffer
     
 
@@ -82,8 +264,8 @@ namespace rtos {
      * Buffer에 접근하는 주기(정수값)
      * @var ProducerArgs::pRingBuffer
      * 데이터를 저장할 버퍼 주소
-     * @var ProducerArgs::pMsgq
-     * 출력할 메세지를 저장할 큐
+     * @var ProducerArgs::pMsgRing
+     * 출력할 메세지를 저장할 버퍼
      * @var ProducerArgs::pDistribution
      * 실행시간이 저장된 배열의 포인터
      */
@@ -93,8 +275,7 @@ namespace rtos {
         mutex* pMutex;
         period interval;
         RingBuffer* pRingBuffer;
-        queue<char*>* pMsgq;
-        mutex* pMsgqMutex;
+        RecordRingBuffer* pMsgRing;
         period* pDistribution;
     } ThreadArgs;
 
@@ -102,17 +283,11 @@ namespace rtos {
 
     /**@struct ObserverArgs
      * @brief stdout에 출력을 담당하는 observer 쓰레드에게 전달할 정보.
-     * @var ObserverArgs::pMsgq
-     * 출력할 메세지가 저장된 큐에 대한 포인터
-     * @var ObserverArgs::pMsgqMutex
-     * 메세지큐에 접근하기 위한 mutex
-     * @var ObserverArgs::counter
-     * 종료 조건
+     * @var ObserverArgs::pMsgRing
+     * 출력할 메세지가 저장된 버퍼에 대한 포인터. 길이가 0인 메세지는 종료를 뜻한다.
      */
     typedef struct observer_args {
-        queue<char*>* pMsgq;
-        mutex* pMsgqMutex;
-        size_t counter;
+        RecordRingBuffer* pMsgRing;
     } ObserverArgs;
         
 }; // rtos
@@ -0,0 +1,199 @@
+/**
+ * @file shardedringbuffer.cpp
+ * @brief Sharded multi-lane RingBuffer with work-stealing consumers
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <new>
+#include <thread>
+#ifdef __linux__
+    #include <sched.h>
+#endif
+
+#include "shardedringbuffer.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief lanes개의 lane을 가진 버퍼를 만든다.
+     *
+     * @param lanes lane 개수. 보통 producer 수 또는 core 수
+     * @param laneSize lane 하나의 크기
+     * @param consumers consumer 개수. consumer는 0부터 consumers - 1까지의 번호를 사용한다.
+     * @param isFifo true이면 다른 consumer의 lane을 훔쳐오지 않는다.
+     *
+     * lanes나 consumers가 0이거나, isFifo인데 home lane이 없는 consumer가 생기면(consumers > lanes)
+     * ShardedRingBufferException을 던진다. 그런 consumer는 영원히 아무것도 꺼내지 못한다.
+     */
+    ShardedRingBuffer::ShardedRingBuffer(size_t lanes, size_t laneSize, size_t consumers, bool isFifo):
+        LANE_NUM(lanes), CONSUMER_NUM(consumers), _isFifo(isFifo),
+        _laneStorage(lanes * sizeof(MpmcRingBuffer), StorageOptions()),
+        _cursorStorage(consumers * sizeof(Cursor), StorageOptions()) {
+
+        if (lanes == 0)
+            throw ShardedRingBufferException("ShardedRingBuffer needs at least one lane");
+        if (consumers == 0)
+            throw ShardedRingBufferException("ShardedRingBuffer needs at least one consumer");
+        if (isFifo && consumers > lanes)
+            throw ShardedRingBufferException("FIFO ShardedRingBuffer needs consumers <= lanes");
+
+        _pLanes = static_cast<MpmcRingBuffer*>(_laneStorage.data());
+        _pCursors = static_cast<Cursor*>(_cursorStorage.data());
+
+        size_t constructed = 0;
+        try {
+            for (; constructed<LANE_NUM; ++constructed)
+                new (&_pLanes[constructed]) MpmcRingBuffer(laneSize);
+        }
+        catch (...) {
+            while (constructed > 0)
+                _pLanes[--constructed].~MpmcRingBuffer();
+            throw;
+        }
+
+        for (size_t i=0; i<CONSUMER_NUM; ++i)
+            new (&_pCursors[i]) Cursor();
+    }
+
+
+    ShardedRingBuffer::~ShardedRingBuffer() {
+        for (size_t i=0; i<LANE_NUM; ++i)
+            _pLanes[i].~MpmcRingBuffer();
+    }
+
+
+    size_t ShardedRingBuffer::laneCount() const noexcept {
+        return LANE_NUM;
+    }
+
+
+    /**
+     * @brief 현재 쓰레드가 실행 중인 core에 해당하는 lane.
+     */
+    size_t ShardedRingBuffer::currentLane() const noexcept {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        if (cpu >= 0)
+            return (size_t)cpu % LANE_NUM;
+#endif
+        return hash<thread::id>()(this_thread::get_id()) % LANE_NUM;
+    }
+
+
+    /**
+     * @brief lane에 빈 공간이 없으면 값을 쓰지 않는다.
+     *
+     * @param lane 저장할 lane. producer마다 다른 lane을 사용한다.
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void ShardedRingBuffer::put(size_t lane, int item) noexcept {
+        _pLanes[lane % LANE_NUM].put(item);
+    }
+
+
+    /**
+     * @brief 데이터를 덮어쓰지 않고 lane에 빈 공간이 생길때까지 대기한다.
+     *
+     * @param lane 저장할 lane. producer마다 다른 lane을 사용한다.
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void ShardedRingBuffer::putWithoutOverride(size_t lane, int item) noexcept {
+        _pLanes[lane % LANE_NUM].putWithoutOverride(item);
+    }
+
+
+    /**
+     * @brief 현재 core의 lane에 저장한다. 쓰레드가 다른 core로 옮겨지면 순서가 보장되지 않는다.
+     */
+    void ShardedRingBuffer::put(int item) noexcept {
+        put(currentLane(), item);
+    }
+
+
+    void ShardedRingBuffer::putWithoutOverride(int item) noexcept {
+        putWithoutOverride(currentLane(), item);
+    }
+
+
+    /**
+     * @brief home lane을 돌아가며 확인하고, 모두 비어 있으면 다른 lane에서 훔쳐온다.
+     *
+     * @param consumer consumer 번호
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼냈으면 true, 확인한 lane이 모두 비어 있으면 false.
+     *
+     * consumer가 CONSUMER_NUM 이상이면 ShardedRingBufferException을 던진다.
+     */
+    bool ShardedRingBuffer::tryGet(size_t consumer, int& item) {
+
+        if (consumer >= CONSUMER_NUM)
+            throw ShardedRingBufferException("consumer out of range");
+
+        size_t homeNum = (LANE_NUM + CONSUMER_NUM - 1 - consumer) / CONSUMER_NUM; // home lane 개수
+        size_t& next = _pCursors[consumer].next;
+
+        // 한 lane만 계속 꺼내지 않도록 마지막으로 꺼낸 다음 lane부터 확인한다.
+        for (size_t i=0; i<homeNum; ++i) {
+            size_t lane = consumer + ((next + i) % homeNum) * CONSUMER_NUM;
+            if (_pLanes[lane].tryGet(item)) {
+                next = (next + i + 1) % homeNum;
+                return true;
+            }
+        }
+
+        if (_isFifo)
+            return false;
+
+        for (size_t i=0; i<LANE_NUM; ++i) {
+            size_t lane = (consumer + i) % LANE_NUM;
+            if (lane % CONSUMER_NUM == consumer)
+                continue;
+            if (_pLanes[lane].tryGet(item))
+                return true;
+        }
+
+        return false;
+    }
+
+
+    /**
+     * @brief 버퍼에서 값을 꺼낸다. 확인한 lane이 모두 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @param consumer consumer 번호
+     *
+     * @return 버퍼의 데이터.
+     */
+    int ShardedRingBuffer::get(size_t consumer) {
+
+        int item;
+
+        if (!tryGet(consumer, item))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 꺼낼 수 있는 값이 없는 경우 값이 저장될 때까지 기다린다.
+     *
+     * @param consumer consumer 번호
+     *
+     * @return 버퍼의 데이터.
+     */
+    int ShardedRingBuffer::getFromNotEmptyBuffer(size_t consumer) {
+
+        int item;
+
+        while (!tryGet(consumer, item))
+            this_thread::yield();
+
+        return item;
+    }
+
+}; // rtos
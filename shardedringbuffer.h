@@ -0,0 +1,90 @@
+/**
+ * @file shardedringbuffer.h
+ * @brief Sharded multi-lane RingBuffer with work-stealing consumers
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _SHARDED_RING_BUFFER_H_
+#define _SHARDED_RING_BUFFER_H_
+
+#include <cstddef>
+#include <string>
+#include <exception>
+
+#include "ringbuffer.h"
+#include "mpmcringbuffer.h"
+#include "storage.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 여러 개의 lane(MpmcRingBuffer)으로 나뉜 RingBuffer.
+     *
+     * producer마다(또는 core마다) lane을 하나씩 사용하므로 producer끼리는 경쟁하지 않는다.
+     * consumer c의 home lane은 lane % CONSUMER_NUM == c 인 lane들이다. consumer는 home lane을
+     * 먼저 꺼내고, 모두 비어 있으면 다른 consumer의 lane에서 훔쳐온다(work stealing).
+     *
+     * isFifo가 true이면 훔쳐오지 않는다. 각 lane을 home consumer 하나만 꺼내므로
+     * 같은 lane을 사용하는 producer의 데이터는 저장한 순서대로 처리된다.
+     * 모든 consumer가 home lane을 하나 이상 가져야 하므로 consumers <= lanes 이어야 한다.
+     */
+    class ShardedRingBuffer {
+
+        private:
+            struct alignas(CACHE_LINE_SIZE) Cursor {
+                size_t next; // 다음에 확인할 home lane의 순번
+            };
+
+            const size_t LANE_NUM;
+            const size_t CONSUMER_NUM;
+            const bool _isFifo;
+
+            // C++11의 new는 alignas(CACHE_LINE_SIZE)를 보장하지 않으므로 정렬된 저장 공간에 직접 생성한다.
+            SlotStorage _laneStorage;
+            MpmcRingBuffer* _pLanes;
+            SlotStorage _cursorStorage;
+            Cursor* _pCursors; // consumer마다 하나. 해당 consumer만 갱신한다.
+
+            size_t currentLane() const noexcept;
+
+        public:
+            ShardedRingBuffer(size_t lanes, size_t laneSize, size_t consumers, bool isFifo = false);
+            ~ShardedRingBuffer();
+
+            ShardedRingBuffer(const ShardedRingBuffer&) = delete;
+            ShardedRingBuffer& operator=(const ShardedRingBuffer&) = delete;
+
+            size_t laneCount() const noexcept;
+
+            void put (size_t lane, int item) noexcept;
+            void putWithoutOverride (size_t lane, int item) noexcept;
+            void put (int item) noexcept;
+            void putWithoutOverride (int item) noexcept;
+
+            bool tryGet (size_t consumer, int& item);
+            int get (size_t consumer);
+            int getFromNotEmptyBuffer (size_t consumer);
+
+    }; // ShardedRingBuffer
+
+
+    class ShardedRingBufferException : public exception {
+
+        private:
+            const string _message;
+
+        public:
+            explicit ShardedRingBufferException(const string& message): _message(message) {}
+
+            const char* what() const throw() {
+                return _message.c_str();
+            }
+
+    }; // ShardedRingBufferException
+
+}; // rtos
+
+#endif // _SHARDED_RING_BUFFER_H_
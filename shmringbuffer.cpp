@@ -0,0 +1,483 @@
+/**
+ * @file shmringbuffer.cpp
+ * @brief RingBuffer placed in a named shared-memory segment for cross-process IPC
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shmringbuffer.h"
+
+
+namespace rtos {
+
+    const uint32_t SHM_MAGIC = 0x52494e47; // "RING". header의 초기화가 끝났음을 나타낸다.
+    const size_t MAX_PEERS = 16; // 하나의 버퍼에 연결할 수 있는 프로세스 수
+    const long PEER_CHECK_INTERVAL_NS = 100000000; // 기다리는 동안 dead peer를 확인하는 주기 (100ms)
+    const int ATTACH_TIMEOUT_MS = 1000; // 만드는 쪽의 초기화를 기다리는 시간
+
+
+    /**
+     * @brief 공유 메모리의 앞부분에 위치하는 header. slot은 그 뒤에 이어진다.
+     */
+    struct ShmRingBuffer::Header {
+        atomic<uint32_t> magic;
+        uint64_t capacity;
+        pthread_mutex_t mutex;
+        pthread_cond_t notEmpty;
+        pthread_cond_t notFull;
+        uint64_t front; // 지금까지 저장된 데이터 개수
+        uint64_t back; // 지금까지 꺼낸 데이터 개수
+        pid_t peers[MAX_PEERS]; // 연결된 프로세스. 0이면 빈 자리
+        uint64_t peerStarts[MAX_PEERS]; // peers의 시작 시각. 종료된 프로세스의 pid가 재사용되었는지 구분한다.
+    };
+
+
+    /**
+     * @brief slot 배열이 시작하는 위치. cache line 단위로 정렬한다.
+     */
+    size_t ShmRingBuffer::dataOffset() noexcept {
+        return (sizeof(Header) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    }
+
+
+    /**
+     * @brief shm_open에 사용할 이름. '/'로 시작하지 않으면 붙인다.
+     */
+    static string shmName(const string& name) {
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+
+
+    static string errorMessage(const char* what) {
+        return string(what) + ": " + strerror(errno);
+    }
+
+
+    /**
+     * @brief /proc/<pid>/stat의 starttime(22번째 field). 알 수 없으면 0.
+     */
+    static uint64_t processStartTime(pid_t pid) {
+
+        char path[64];
+        char line[1024];
+        snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+
+        FILE* pFile = fopen(path, "r");
+        if (pFile == nullptr)
+            return 0;
+        bool isRead = fgets(line, sizeof(line), pFile) != nullptr;
+        fclose(pFile);
+        if (!isRead)
+            return 0;
+
+        // 2번째 field(comm)에는 공백과 괄호가 들어갈 수 있으므로 마지막 ')' 뒤부터 센다.
+        const char* p = strrchr(line, ')');
+        unsigned long long start;
+        if (p == nullptr || sscanf(p + 1,
+                " %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %llu",
+                &start) != 1)
+            return 0;
+
+        return start;
+    }
+
+
+    /**
+     * @brief 해당 프로세스가 종료되었으면 true.
+     * kill(pid, 0)만으로는 종료된 프로세스의 pid를 다른 프로세스가 재사용하면 살아 있는 것으로 보이므로,
+     * 등록할 때 기록한 시작 시각과 현재 그 pid의 시작 시각을 비교한다. 시작 시각을 기록하지 못했으면(0) kill만 사용한다.
+     */
+    static bool isDead(pid_t pid, uint64_t start) {
+        if (pid == 0)
+            return false;
+        if (kill(pid, 0) == -1 && errno == ESRCH)
+            return true;
+        return start != 0 && processStartTime(pid) != start;
+    }
+
+
+    /**
+     * @brief 이름이 name인 공유 메모리를 새로 만들고 길이 n의 버퍼를 초기화한다.
+     * 같은 이름의 공유 메모리가 이미 있거나 n이 0이면 SharedMemoryException을 던진다.
+     *
+     * @param name 공유 메모리 이름
+     * @param n Buffer size. 1 이상이어야 한다.
+     */
+    ShmRingBuffer::ShmRingBuffer(const string& name, size_t n):
+        _pHeader(nullptr), _pBuffer(nullptr), _mappedSize(0), _name(shmName(name)), _isOwner(true), _peerIndex(-1) {
+
+        // 공유 메모리를 만들기 전에 확인해야 같은 이름이 남지 않는다.
+        if (n == 0)
+            throw SharedMemoryException("buffer size must be greater than 0");
+
+        int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw SharedMemoryException(errorMessage("shm_open"));
+
+        size_t size = dataOffset() + n * sizeof(int);
+        if (ftruncate(fd, size) < 0) {
+            string message = errorMessage("ftruncate");
+            close(fd);
+            shm_unlink(_name.c_str());
+            throw SharedMemoryException(message);
+        }
+
+        try {
+            map(fd, size);
+        }
+        catch (...) {
+            shm_unlink(_name.c_str());
+            throw;
+        }
+
+        // ftruncate로 늘어난 영역은 0으로 채워져 있다.
+        _pHeader->capacity = n;
+        _pHeader->front = 0;
+        _pHeader->back = 0;
+
+        pthread_mutexattr_t mutexAttr;
+        pthread_mutexattr_init(&mutexAttr);
+        pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&mutexAttr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&_pHeader->mutex, &mutexAttr);
+        pthread_mutexattr_destroy(&mutexAttr);
+
+        pthread_condattr_t condAttr;
+        pthread_condattr_init(&condAttr);
+        pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+        pthread_cond_init(&_pHeader->notEmpty, &condAttr);
+        pthread_cond_init(&_pHeader->notFull, &condAttr);
+        pthread_condattr_destroy(&condAttr);
+
+        registerPeer();
+        _pHeader->magic.store(SHM_MAGIC, memory_order_release);
+    }
+
+
+    /**
+     * @brief 다른 프로세스가 만든 공유 메모리 name에 연결한다.
+     * 공유 메모리가 없거나 초기화되지 않았으면 SharedMemoryException을 던진다.
+     *
+     * @param name 공유 메모리 이름
+     */
+    ShmRingBuffer::ShmRingBuffer(const string& name):
+        _pHeader(nullptr), _pBuffer(nullptr), _mappedSize(0), _name(shmName(name)), _isOwner(false), _peerIndex(-1) {
+
+        int fd = shm_open(_name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            throw SharedMemoryException(errorMessage("shm_open"));
+
+        // 만드는 쪽이 아직 ftruncate하지 않았을 수 있다.
+        struct stat st;
+        for (int i=0; ; ++i) {
+            if (fstat(fd, &st) < 0) {
+                string message = errorMessage("fstat");
+                close(fd);
+                throw SharedMemoryException(message);
+            }
+            if ((size_t)st.st_size >= dataOffset())
+                break;
+            if (i >= ATTACH_TIMEOUT_MS) {
+                close(fd);
+                throw SharedMemoryException("shared memory is not initialized");
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+
+        map(fd, st.st_size);
+
+        for (int i=0; _pHeader->magic.load(memory_order_acquire) != SHM_MAGIC; ++i) {
+            if (i >= ATTACH_TIMEOUT_MS) {
+                detach();
+                throw SharedMemoryException("shared memory is not initialized");
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+
+        if (dataOffset() + _pHeader->capacity * sizeof(int) != _mappedSize) {
+            detach();
+            throw SharedMemoryException("shared memory size does not match its header");
+        }
+
+        lock();
+        registerPeer();
+        unlock();
+
+        if (_peerIndex < 0) {
+            detach();
+            throw SharedMemoryException("too many processes attached");
+        }
+    }
+
+
+    ShmRingBuffer::~ShmRingBuffer() {
+        detach();
+    }
+
+
+    /**
+     * @brief fd를 size만큼 mmap하고 fd를 닫는다.
+     */
+    void ShmRingBuffer::map(int fd, size_t size) {
+
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (p == MAP_FAILED)
+            throw SharedMemoryException(errorMessage("mmap"));
+
+        _mappedSize = size;
+        _pHeader = static_cast<Header*>(p);
+        _pBuffer = reinterpret_cast<int*>(static_cast<char*>(p) + dataOffset());
+    }
+
+
+    /**
+     * @brief header의 프로세스 목록에 자신을 등록한다. 만드는 쪽이 아니면 lock을 잡은 상태에서 호출한다.
+     */
+    void ShmRingBuffer::registerPeer() {
+        for (size_t i=0; i<MAX_PEERS; ++i) {
+            if (_pHeader->peers[i] == 0) {
+                _pHeader->peers[i] = getpid();
+                _pHeader->peerStarts[i] = processStartTime(getpid());
+                _peerIndex = (int)i;
+                return;
+            }
+        }
+    }
+
+
+    /**
+     * @brief 공유 mutex를 잡는다. 다른 프로세스가 mutex를 잡은 채 종료되었으면 복구한다.
+     * index는 각 연산의 마지막에 갱신하므로 중단된 연산은 일어나지 않은 것과 같다.
+     */
+    void ShmRingBuffer::lock() noexcept {
+        if (pthread_mutex_lock(&_pHeader->mutex) == EOWNERDEAD)
+            pthread_mutex_consistent(&_pHeader->mutex);
+    }
+
+
+    void ShmRingBuffer::unlock() noexcept {
+        pthread_mutex_unlock(&_pHeader->mutex);
+    }
+
+
+    bool ShmRingBuffer::hasDeadPeerLocked() const noexcept {
+        for (size_t i=0; i<MAX_PEERS; ++i) {
+            if (isDead(_pHeader->peers[i], _pHeader->peerStarts[i]))
+                return true;
+        }
+        return false;
+    }
+
+
+    /**
+     * @brief data가 true이면 데이터가 저장될 때까지, false이면 빈 공간이 생길 때까지 기다린다.
+     * lock을 잡은 상태에서 호출한다. 기다리는 동안 dead peer가 발견되면 lock을 놓고 DeadPeerException을 던진다.
+     */
+    void ShmRingBuffer::waitFor(bool data) {
+
+        pthread_cond_t* pCond = data ? &_pHeader->notEmpty : &_pHeader->notFull;
+
+        while (data ? (_pHeader->front == _pHeader->back)
+                    : (_pHeader->front - _pHeader->back == _pHeader->capacity)) {
+
+            if (hasDeadPeerLocked()) {
+                unlock();
+                throw DeadPeerException();
+            }
+
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_nsec += PEER_CHECK_INTERVAL_NS;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000;
+            }
+
+            if (pthread_cond_timedwait(pCond, &_pHeader->mutex, &deadline) == EOWNERDEAD)
+                pthread_mutex_consistent(&_pHeader->mutex);
+        }
+    }
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 없으면 값을 쓰지 않는다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void ShmRingBuffer::put(int item) noexcept {
+
+        lock();
+
+        /* Critical section start */
+        bool stored = (_pHeader->front - _pHeader->back < _pHeader->capacity);
+        if (stored) {
+            _pBuffer[_pHeader->front % _pHeader->capacity] = item;
+            _pHeader->front++;
+        }
+        /* Critical section end */
+
+        unlock();
+        if (stored)
+            pthread_cond_signal(&_pHeader->notEmpty);
+    }
+
+
+    /**
+     * @brief 데이터를 덮어쓰지 않고 빈 공간이 생길때까지 대기한다.
+     * 기다리는 동안 다른 프로세스가 detach하지 않고 종료되면 DeadPeerException을 던진다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void ShmRingBuffer::putWithoutOverride(int item) {
+
+        lock();
+
+        /* Critical section start */
+        waitFor(false);
+        _pBuffer[_pHeader->front % _pHeader->capacity] = item;
+        _pHeader->front++;
+        /* Critical section end */
+
+        unlock();
+        pthread_cond_signal(&_pHeader->notEmpty);
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int ShmRingBuffer::get() {
+
+        lock();
+
+        /* Critical section start */
+        if (_pHeader->front == _pHeader->back) {
+            unlock();
+            throw EmptyBufferReadException();
+        }
+
+        int item = _pBuffer[_pHeader->back % _pHeader->capacity];
+        _pHeader->back++;
+        /* Critical section end */
+
+        unlock();
+        pthread_cond_signal(&_pHeader->notFull);
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+     * 기다리는 동안 다른 프로세스가 detach하지 않고 종료되면 DeadPeerException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int ShmRingBuffer::getFromNotEmptyBuffer() {
+
+        lock();
+
+        /* Critical section start */
+        waitFor(true);
+        int item = _pBuffer[_pHeader->back % _pHeader->capacity];
+        _pHeader->back++;
+        /* Critical section end */
+
+        unlock();
+        pthread_cond_signal(&_pHeader->notFull);
+
+        return item;
+    }
+
+
+    /**
+     * @brief 프로세스 목록에서 자신을 지우고 공유 메모리의 mapping을 해제한다.
+     * 공유 메모리를 만든 쪽이면 이름도 지운다. 이미 연결된 다른 프로세스는 계속 사용할 수 있다.
+     */
+    void ShmRingBuffer::detach() noexcept {
+
+        if (_pHeader == nullptr)
+            return;
+
+        if (_peerIndex >= 0) {
+            lock();
+            _pHeader->peers[_peerIndex] = 0;
+            unlock();
+            _peerIndex = -1;
+        }
+
+        munmap(_pHeader, _mappedSize);
+        _pHeader = nullptr;
+        _pBuffer = nullptr;
+
+        if (_isOwner)
+            shm_unlink(_name.c_str());
+    }
+
+
+    bool ShmRingBuffer::isAttached() const noexcept {
+        return _pHeader != nullptr;
+    }
+
+
+    /**
+     * @brief detach하지 않고 종료된 프로세스가 있으면 true.
+     */
+    bool ShmRingBuffer::hasDeadPeer() noexcept {
+
+        lock();
+        bool dead = hasDeadPeerLocked();
+        unlock();
+
+        return dead;
+    }
+
+
+    /**
+     * @brief 종료된 프로세스를 목록에서 지운다. 이후 blocking 함수는 다시 기다릴 수 있다.
+     *
+     * @return 지운 프로세스 수.
+     */
+    size_t ShmRingBuffer::reapDeadPeers() noexcept {
+
+        size_t reaped = 0;
+
+        lock();
+        for (size_t i=0; i<MAX_PEERS; ++i) {
+            if (isDead(_pHeader->peers[i], _pHeader->peerStarts[i])) {
+                _pHeader->peers[i] = 0;
+                reaped++;
+            }
+        }
+        unlock();
+
+        return reaped;
+    }
+
+
+    /**
+     * @brief 이름이 name인 공유 메모리를 지운다. 비정상 종료로 남은 공유 메모리를 정리할 때 사용한다.
+     */
+    void ShmRingBuffer::remove(const string& name) noexcept {
+        shm_unlink(shmName(name).c_str());
+    }
+
+}; // rtos
@@ -0,0 +1,106 @@
+/**
+ * @file shmringbuffer.h
+ * @brief RingBuffer placed in a named shared-memory segment for cross-process IPC
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _SHM_RING_BUFFER_H_
+#define _SHM_RING_BUFFER_H_
+
+#include <cstddef>
+#include <string>
+#include <exception>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 서로 다른 프로세스가 공유하는 RingBuffer.
+     *
+     * 버퍼의 header(index, 동기화 객체, 연결된 프로세스 목록)와 slot을 shm_open으로 만든
+     * 이름 있는 공유 메모리에 둔다. 동기화에는 process-shared robust mutex와
+     * process-shared condition variable을 사용하므로 RingBuffer와 같은 의미를 가진다.
+     *
+     * 연결된 프로세스는 header에 pid를 기록하고 detach할 때 지운다. detach하지 않고 종료된
+     * 프로세스는 dead peer로 판단하며, 이 경우 blocking 함수는 영원히 기다리지 않고
+     * DeadPeerException을 던진다. mutex를 잡은 채 종료된 경우에도 robust mutex로 복구한다.
+     * pid가 재사용되어도 살아 있는 것으로 보지 않도록 pid와 함께 프로세스의 시작 시각을 기록한다.
+     */
+    class ShmRingBuffer {
+
+        private:
+            struct Header;
+
+            Header* _pHeader;
+            int* _pBuffer;
+            size_t _mappedSize;
+            string _name;
+            bool _isOwner; // 공유 메모리를 만든 프로세스이면 소멸할 때 이름을 지운다.
+            int _peerIndex; // header의 프로세스 목록에서 자신의 위치. detach하면 -1
+
+            static size_t dataOffset() noexcept;
+
+            void map(int fd, size_t size);
+            void registerPeer();
+            void lock() noexcept;
+            void unlock() noexcept;
+            bool hasDeadPeerLocked() const noexcept;
+            void waitFor(bool data);
+
+        public:
+            ShmRingBuffer(const string& name, size_t n);
+            explicit ShmRingBuffer(const string& name);
+            ~ShmRingBuffer();
+
+            ShmRingBuffer(const ShmRingBuffer&) = delete;
+            ShmRingBuffer& operator=(const ShmRingBuffer&) = delete;
+
+            void put (int item) noexcept;
+            void putWithoutOverride (int item);
+            int get();
+            int getFromNotEmptyBuffer ();
+
+            void detach() noexcept;
+            bool isAttached() const noexcept;
+            bool hasDeadPeer() noexcept;
+            size_t reapDeadPeers() noexcept;
+
+            static void remove(const string& name) noexcept;
+
+    }; // ShmRingBuffer
+
+
+    class SharedMemoryException : public exception {
+
+        private:
+            const string _message;
+
+        public:
+            explicit SharedMemoryException(const string& message): _message(message) {}
+
+            const char* what() const throw() {
+                return _message.c_str();
+            }
+
+    }; // SharedMemoryException
+
+
+    class DeadPeerException : public exception {
+
+        private:
+            const string _message = "Peer process terminated without detaching";
+
+        public:
+            const char* what() const throw() {
+                return _message.c_str();
+            }
+
+    }; // DeadPeerException
+
+}; // rtos
+
+#endif // _SHM_RING_BUFFER_H_
@@ -0,0 +1,262 @@
+/**
+ * @file simulator.cpp
+ * @brief Discrete-event virtual-time simulator driving a RingBuffer
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <algorithm>
+
+#include "simulator.h"
+
+
+namespace rtos {
+
+    const double MIN_PERIOD = 1e-6; // 주기가 0이면 같은 시각의 event가 끝없이 생기므로 최솟값을 둔다.
+
+
+    /**
+     * @brief config의 조건으로 시뮬레이션을 준비한다.
+     *
+     * @param config 버퍼 크기, 쓰레드 수, 주기 분포, blocking 여부, 진행 시간, seed
+     */
+    Simulator::Simulator(const SimulationConfig& config):
+        _config(config), _buffer(max(config.bufferSize, (size_t)1)) {
+
+        for (size_t i=0; i<_config.producers; ++i) {
+            seed_seq seed{ (uint64_t)_config.seed, (uint64_t)0, (uint64_t)i };
+            _producerRandom.push_back(mt19937_64(seed));
+        }
+        for (size_t i=0; i<_config.consumers; ++i) {
+            seed_seq seed{ (uint64_t)_config.seed, (uint64_t)1, (uint64_t)i };
+            _consumerRandom.push_back(mt19937_64(seed));
+        }
+
+        _order = 0;
+        _nextItem = 0;
+        _now = 0.0;
+        _occupancyArea = 0.0;
+        _latencySum = 0.0;
+        _maxLatency = 0.0;
+        _producerBlockedTime = 0.0;
+        _consumerBlockedTime = 0.0;
+    }
+
+
+    /**
+     * @brief spec의 분포에서 다음 주기를 뽑는다.
+     */
+    double Simulator::sample(const PeriodSpec& spec, mt19937_64& random) {
+
+        double value;
+
+        switch (spec.distribution) {
+            case Distribution::NORMAL:
+                value = normal_distribution<double>(spec.mean, spec.spread)(random);
+                break;
+            case Distribution::UNIFORM:
+                value = uniform_real_distribution<double>(spec.mean - spec.spread, spec.mean + spec.spread)(random);
+                break;
+            case Distribution::EXPONENTIAL:
+                value = exponential_distribution<double>(1.0 / spec.mean)(random);
+                break;
+            default:
+                value = spec.mean;
+                break;
+        }
+
+        return max(value, MIN_PERIOD);
+    }
+
+
+    void Simulator::schedule(EventType type, size_t thread, double time) {
+        Event event = { time, _order++, type, thread };
+        _events.push(event);
+    }
+
+
+    /**
+     * @brief producer가 데이터를 하나 저장한다.
+     *
+     * @return 저장했거나 버렸으면 true, 빈 공간을 기다려야 하면 false.
+     */
+    bool Simulator::produce() {
+
+        // putWithoutOverride는 가득 찬 버퍼에서 기다리므로 손실로 세지 않는다.
+        if (_config.blockingPut && _enqueueTimes.size() >= max(_config.bufferSize, (size_t)1))
+            return false;
+
+        if (_buffer.tryPut(_nextItem)) {
+            _enqueueTimes.push_back(_now);
+            wakeConsumer();
+        }
+        ++_nextItem;
+
+        return true;
+    }
+
+
+    /**
+     * @brief consumer가 데이터를 하나 꺼낸다.
+     *
+     * @return 꺼냈거나 빈 버퍼에 접근했으면 true, 데이터를 기다려야 하면 false.
+     */
+    bool Simulator::consume() {
+
+        if (_config.blockingGet && _enqueueTimes.empty())
+            return false;
+
+        int item;
+        if (_buffer.tryGet(item)) {
+            double latency = _now - _enqueueTimes.front();
+            _enqueueTimes.pop_front();
+            _latencySum += latency;
+            _maxLatency = max(_maxLatency, latency);
+            wakeProducer();
+        }
+
+        return true;
+    }
+
+
+    /**
+     * @brief 데이터를 기다리던 consumer가 있으면 지금 꺼내고 다음 주기를 예약한다.
+     */
+    void Simulator::wakeConsumer() {
+
+        if (_blockedConsumers.empty())
+            return;
+
+        Waiter waiter = _blockedConsumers.front();
+        _blockedConsumers.pop_front();
+        _consumerBlockedTime += _now - waiter.since;
+
+        consume();
+        schedule(EventType::CONSUME, waiter.thread,
+            _now + sample(_config.consumerPeriod, _consumerRandom[waiter.thread]));
+    }
+
+
+    /**
+     * @brief 빈 공간을 기다리던 producer가 있으면 지금 저장하고 다음 주기를 예약한다.
+     */
+    void Simulator::wakeProducer() {
+
+        if (_blockedProducers.empty())
+            return;
+
+        Waiter waiter = _blockedProducers.front();
+        _blockedProducers.pop_front();
+        _producerBlockedTime += _now - waiter.since;
+
+        produce();
+        schedule(EventType::PRODUCE, waiter.thread,
+            _now + sample(_config.producerPeriod, _producerRandom[waiter.thread]));
+    }
+
+
+    /**
+     * @brief duration까지 event를 시간 순서대로 처리한다. Simulator 하나에 대해 한 번만 호출한다.
+     *
+     * @return 시뮬레이션 결과
+     */
+    SimulationResult Simulator::run() {
+
+        SimulationResult result;
+        result.config = _config;
+        result.events = 0;
+
+        for (size_t i=0; i<_config.producers; ++i)
+            schedule(EventType::PRODUCE, i, sample(_config.producerPeriod, _producerRandom[i]));
+        for (size_t i=0; i<_config.consumers; ++i)
+            schedule(EventType::CONSUME, i, sample(_config.consumerPeriod, _consumerRandom[i]));
+
+        while (!_events.empty() && _events.top().time <= _config.duration) {
+
+            Event event = _events.top();
+            _events.pop();
+
+            _occupancyArea += _enqueueTimes.size() * (event.time - _now);
+            _now = event.time;
+            ++result.events;
+
+            if (event.type == EventType::PRODUCE) {
+                if (produce()) {
+                    schedule(EventType::PRODUCE, event.thread,
+                        _now + sample(_config.producerPeriod, _producerRandom[event.thread]));
+                }
+                else {
+                    Waiter waiter = { event.thread, _now };
+                    _blockedProducers.push_back(waiter);
+                }
+            }
+            else {
+                if (consume()) {
+                    schedule(EventType::CONSUME, event.thread,
+                        _now + sample(_config.consumerPeriod, _consumerRandom[event.thread]));
+                }
+                else {
+                    Waiter waiter = { event.thread, _now };
+                    _blockedConsumers.push_back(waiter);
+                }
+            }
+        }
+
+        // 끝날 때까지 기다리고 있던 시간도 포함한다.
+        _occupancyArea += _enqueueTimes.size() * (_config.duration - _now);
+        for (size_t i=0; i<_blockedProducers.size(); ++i)
+            _producerBlockedTime += _config.duration - _blockedProducers[i].since;
+        for (size_t i=0; i<_blockedConsumers.size(); ++i)
+            _consumerBlockedTime += _config.duration - _blockedConsumers[i].since;
+
+        RingBufferStats& stats = result.stats;
+        stats = _buffer.stats();
+
+        uint64_t puts = stats.enqueues + stats.droppedPuts;
+        uint64_t gets = stats.dequeues + stats.emptyReads;
+        result.lossRatio = puts ? (double)stats.droppedPuts / puts : 0.0;
+        result.emptyReadRatio = gets ? (double)stats.emptyReads / gets : 0.0;
+        result.meanOccupancy = _config.duration > 0 ? _occupancyArea / _config.duration : 0.0;
+        result.meanLatency = stats.dequeues ? _latencySum / stats.dequeues : 0.0;
+        result.maxLatency = _maxLatency;
+        result.producerBlockedTime = _producerBlockedTime;
+        result.consumerBlockedTime = _consumerBlockedTime;
+
+        return result;
+    }
+
+
+    /**
+     * @brief base 조건에서 버퍼 크기, producer 수, consumer 수의 모든 조합을 시뮬레이션한다.
+     * 조합마다 같은 seed를 사용하므로 결과의 차이는 변경한 조건에서만 생긴다.
+     *
+     * @param base 나머지 조건
+     * @param bufferSizes 시험할 버퍼 크기들
+     * @param producerCounts 시험할 producer 수들
+     * @param consumerCounts 시험할 consumer 수들
+     *
+     * @return 조합마다의 결과. 버퍼 크기, producer 수, consumer 수 순서로 정렬되어 있다.
+     */
+    vector<SimulationResult> Simulator::sweep(const SimulationConfig& base,
+        const vector<size_t>& bufferSizes, const vector<size_t>& producerCounts,
+        const vector<size_t>& consumerCounts) {
+
+        vector<SimulationResult> results;
+
+        for (size_t i=0; i<bufferSizes.size(); ++i) {
+            for (size_t j=0; j<producerCounts.size(); ++j) {
+                for (size_t k=0; k<consumerCounts.size(); ++k) {
+                    SimulationConfig config = base;
+                    config.bufferSize = bufferSizes[i];
+                    config.producers = producerCounts[j];
+                    config.consumers = consumerCounts[k];
+                    results.push_back(Simulator(config).run());
+                }
+            }
+        }
+
+        return results;
+    }
+
+}; // rtos
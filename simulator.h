@@ -0,0 +1,161 @@
+/**
+ * @file simulator.h
+ * @brief Discrete-event virtual-time simulator driving a RingBuffer
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _SIMULATOR_H_
+#define _SIMULATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 생성/처리 주기의 분포.
+     */
+    enum class Distribution {
+        CONSTANT,    // 항상 mean
+        NORMAL,      // 평균 mean, 표준편차 spread (음수는 0으로 본다)
+        UNIFORM,     // [mean - spread, mean + spread]
+        EXPONENTIAL, // 평균 mean (Poisson 도착)
+    };
+
+
+    /**@struct PeriodSpec
+     * @brief 쓰레드의 동작 주기. 단위는 가상 시간 millisecond이다.
+     */
+    typedef struct period_spec {
+        Distribution distribution = Distribution::NORMAL;
+        double mean = 20.0;
+        double spread = 1.0;
+    } PeriodSpec;
+
+
+    /**@struct SimulationConfig
+     * @brief 시뮬레이션 한 번의 조건.
+     * @var SimulationConfig::blockingPut
+     * true이면 producer가 putWithoutOverride처럼 빈 공간을 기다리고, false이면 put처럼 버린다.
+     * @var SimulationConfig::blockingGet
+     * true이면 consumer가 getFromNotEmptyBuffer처럼 기다리고, false이면 get처럼 빈 버퍼 접근으로 끝난다.
+     * @var SimulationConfig::duration
+     * 가상 시간으로 진행할 시간 (milliseconds)
+     * @var SimulationConfig::seed
+     * 같은 seed와 조건이면 항상 같은 결과가 나온다.
+     */
+    typedef struct simulation_config {
+        size_t bufferSize = 10;
+        size_t producers = 1;
+        size_t consumers = 1;
+        PeriodSpec producerPeriod;
+        PeriodSpec consumerPeriod;
+        bool blockingPut = false;
+        bool blockingGet = false;
+        double duration = 5000.0;
+        uint64_t seed = 1;
+    } SimulationConfig;
+
+
+    /**@struct SimulationResult
+     * @brief 시뮬레이션 결과. 시간은 모두 가상 시간 millisecond이다.
+     * @var SimulationResult::stats
+     * 시뮬레이션에 사용한 RingBuffer의 지표
+     * @var SimulationResult::events
+     * 처리한 event 개수
+     * @var SimulationResult::meanOccupancy
+     * 시간 가중 평균 저장 개수
+     * @var SimulationResult::meanLatency
+     * 데이터가 저장된 뒤 꺼내질 때까지 걸린 시간의 평균
+     */
+    typedef struct simulation_result {
+        SimulationConfig config;
+        RingBufferStats stats;
+        uint64_t events;
+        double lossRatio;
+        double emptyReadRatio;
+        double meanOccupancy;
+        double meanLatency;
+        double maxLatency;
+        double producerBlockedTime;
+        double consumerBlockedTime;
+    } SimulationResult;
+
+
+    /**
+     * @brief 실제 RingBuffer를 가상 시계로 구동하는 discrete-event 시뮬레이터.
+     *
+     * producer, consumer 쓰레드의 동작을 event queue의 event로 바꾸어 시간 순서대로 처리하므로
+     * sleep 없이 실행되고, seed가 같으면 결과가 같다. put/get은 실제 RingBuffer의
+     * tryPut/tryGet을 호출하므로 drop-if-full, 빈 버퍼 접근 의미와 지표가 testcase와 같다.
+     * blocking 모드에서 기다리는 쓰레드는 실제로 잠들지 않고 대기열에 넣었다가,
+     * 상대방이 공간이나 데이터를 만든 시각에 다시 실행한다.
+     */
+    class Simulator {
+
+        private:
+            enum class EventType { PRODUCE, CONSUME };
+
+            struct Event {
+                double time;
+                uint64_t order; // 같은 시각의 event는 만들어진 순서대로 처리한다.
+                EventType type;
+                size_t thread;
+
+                bool operator>(const Event& other) const {
+                    return time != other.time ? time > other.time : order > other.order;
+                }
+            };
+
+            struct Waiter {
+                size_t thread;
+                double since;
+            };
+
+            const SimulationConfig _config;
+            RingBuffer _buffer;
+            priority_queue<Event, vector<Event>, greater<Event> > _events;
+            vector<mt19937_64> _producerRandom; // 쓰레드마다 따로 두어 event 순서와 관계없이 재현된다.
+            vector<mt19937_64> _consumerRandom;
+            deque<Waiter> _blockedProducers;
+            deque<Waiter> _blockedConsumers;
+            deque<double> _enqueueTimes; // 버퍼에 있는 데이터가 저장된 시각 (FIFO)
+            uint64_t _order;
+            int _nextItem;
+            double _now;
+            double _occupancyArea; // 저장 개수 x 시간의 합
+            double _latencySum;
+            double _maxLatency;
+            double _producerBlockedTime;
+            double _consumerBlockedTime;
+
+            double sample(const PeriodSpec& spec, mt19937_64& random);
+            void schedule(EventType type, size_t thread, double time);
+            bool produce();
+            bool consume();
+            void wakeConsumer();
+            void wakeProducer();
+
+        public:
+            explicit Simulator(const SimulationConfig& config);
+
+            SimulationResult run();
+
+            static vector<SimulationResult> sweep(const SimulationConfig& base,
+                const vector<size_t>& bufferSizes, const vector<size_t>& producerCounts,
+                const vector<size_t>& consumerCounts);
+
+    }; // Simulator
+
+}; // rtos
+
+#endif // _SIMULATOR_H_
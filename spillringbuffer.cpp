@@ -0,0 +1,404 @@
+/**
+ * @file spillringbuffer.cpp
+ * @brief RingBuffer that spills overflow to memory-mapped segment files instead of dropping it
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "spillringbuffer.h"
+#include "storage.h"
+
+
+namespace rtos {
+
+    const size_t SPARE_SEGMENTS = 2; // 미리 만들어 두는 예비 segment 개수
+    const chrono::milliseconds RETRY_DELAY(100); // segment를 만들지 못했을 때 다시 시도하기까지의 시간
+
+
+    /**
+     * @brief 메모리 버퍼의 크기가 n이고 directory에 spill segment를 만드는 버퍼.
+     * 예비 segment를 미리 만들어 directory를 확인하며, 실패하면 StorageException을 던진다.
+     *
+     * @param n 메모리 버퍼 크기
+     * @param directory segment 파일을 만들 디렉토리
+     * @param segmentItems segment 하나에 저장하는 데이터 개수
+     * @param maxSegments 동시에 사용할 수 있는 segment의 최대 개수
+     */
+    SpillRingBuffer::SpillRingBuffer(size_t n, const string& directory, size_t segmentItems, size_t maxSegments):
+        BUFFER_SIZE(n), _directory(directory), SEGMENT_ITEMS(segmentItems), MAX_SEGMENTS(maxSegments) {
+
+        _pBuffer = new int[BUFFER_SIZE];
+        _front = 0;
+        _back = 0;
+        _spilledCount = 0;
+        _droppedCount = 0;
+        _isStopping = false;
+
+        try {
+            while (needsSpare())
+                _spares.push_back(createSegment());
+        }
+        catch (...) {
+            for (size_t i=0; i<_spares.size(); ++i)
+                destroySegment(_spares[i]);
+            delete [] _pBuffer;
+            throw;
+        }
+
+        _maintainer = thread(&SpillRingBuffer::maintain, this);
+    }
+
+
+    SpillRingBuffer::~SpillRingBuffer() {
+
+        unique_lock<mutex> lock(_mutex);
+        _isStopping = true;
+        lock.unlock();
+        _maintenance.notify_one();
+        _maintainer.join();
+
+        for (size_t i=0; i<_spill.size(); ++i)
+            destroySegment(_spill[i]);
+        for (size_t i=0; i<_spares.size(); ++i)
+            destroySegment(_spares[i]);
+        for (size_t i=0; i<_retired.size(); ++i)
+            destroySegment(_retired[i]);
+        delete [] _pBuffer;
+    }
+
+
+    /**
+     * @brief segment 파일을 만들어 mmap한다. 파일 이름은 바로 지운다.
+     */
+    SpillRingBuffer::Segment* SpillRingBuffer::createSegment() {
+
+        string path = _directory + "/rtos-spill-XXXXXX";
+        vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+
+        int fd = mkstemp(name.data());
+        if (fd < 0)
+            throw StorageException(string("mkstemp: ") + strerror(errno));
+        unlink(name.data());
+
+        size_t bytes = SEGMENT_ITEMS * sizeof(int);
+        if (ftruncate(fd, bytes) < 0) {
+            string message = string("ftruncate: ") + strerror(errno);
+            close(fd);
+            throw StorageException(message);
+        }
+
+        // 저장할 때 page fault로 disk를 기다리지 않도록 미리 읽어 둔다.
+        void* pData = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        if (pData == MAP_FAILED) {
+            string message = string("mmap: ") + strerror(errno);
+            close(fd);
+            throw StorageException(message);
+        }
+
+        Segment* pSegment = new Segment;
+        pSegment->fd = fd;
+        pSegment->pData = static_cast<int*>(pData);
+        pSegment->readPos = 0;
+        pSegment->writePos = 0;
+
+        return pSegment;
+    }
+
+
+    void SpillRingBuffer::destroySegment(Segment* pSegment) noexcept {
+        munmap(pSegment->pData, SEGMENT_ITEMS * sizeof(int));
+        close(pSegment->fd);
+        delete pSegment;
+    }
+
+
+    /**
+     * @brief 예비 segment를 더 만들어야 하는지 확인한다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    bool SpillRingBuffer::needsSpare() const noexcept {
+        return _spares.size() < SPARE_SEGMENTS && _spill.size() + _spares.size() < MAX_SEGMENTS;
+    }
+
+
+    /**
+     * @brief 관리 쓰레드. 예비 segment를 채우고 남는 segment를 닫는다.
+     * 파일 system call은 모두 lock을 놓은 상태에서 하므로 producer와 consumer는 disk I/O를 기다리지 않는다.
+     */
+    void SpillRingBuffer::maintain() noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        while (true) {
+            _maintenance.wait(lock, [this]() { return _isStopping || !_retired.empty() || needsSpare(); });
+            if (_isStopping)
+                return;
+
+            vector<Segment*> retired;
+            retired.swap(_retired);
+            bool isCreating = needsSpare();
+            lock.unlock();
+
+            for (size_t i=0; i<retired.size(); ++i)
+                destroySegment(retired[i]);
+
+            // segment는 관리 쓰레드만 만들므로 lock을 놓은 동안 개수가 MAX_SEGMENTS를 넘지 않는다.
+            Segment* pSegment = nullptr;
+            if (isCreating) {
+                try {
+                    pSegment = createSegment();
+                }
+                catch (...) {
+                }
+            }
+
+            lock.lock();
+            if (pSegment != nullptr) {
+                _spares.push_back(pSegment);
+                _notFull.notify_all();
+            }
+            else if (isCreating) {
+                _maintenance.wait_for(lock, RETRY_DELAY);
+            }
+        }
+    }
+
+
+    /**
+     * @brief 예비 segment를 하나 꺼내고 관리 쓰레드에게 다시 채우도록 알린다. _mutex를 잡은 상태에서 호출해야 한다.
+     *
+     * @return segment. 예비 segment가 없으면 nullptr
+     */
+    SpillRingBuffer::Segment* SpillRingBuffer::acquireSegment() noexcept {
+
+        if (_spares.empty())
+            return nullptr;
+
+        Segment* pSegment = _spares.back();
+        _spares.pop_back();
+        _maintenance.notify_one();
+
+        return pSegment;
+    }
+
+
+    /**
+     * @brief 다 읽은 segment를 예비 목록으로 돌려준다. 남는 segment는 관리 쓰레드가 닫는다.
+     * _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    void SpillRingBuffer::recycleSegment(Segment* pSegment) noexcept {
+
+        pSegment->readPos = 0;
+        pSegment->writePos = 0;
+
+        if (_spares.size() < SPARE_SEGMENTS) {
+            _spares.push_back(pSegment);
+        }
+        else {
+            _retired.push_back(pSegment);
+            _maintenance.notify_one();
+        }
+    }
+
+
+    bool SpillRingBuffer::isEmpty() const noexcept {
+        return _front == _back && _spilledCount == 0;
+    }
+
+
+    /**
+     * @brief spill에 하나 더 쓸 수 있는지 확인한다. _mutex를 잡은 상태에서 호출해야 한다.
+     */
+    bool SpillRingBuffer::canSpill() const noexcept {
+        return (!_spill.empty() && _spill.back()->writePos < SEGMENT_ITEMS)
+            || (!_spares.empty() && _spill.size() < MAX_SEGMENTS);
+    }
+
+
+    /**
+     * @brief 순서를 지키며 메모리 버퍼나 spill에 저장한다. _mutex를 잡은 상태에서 호출해야 한다.
+     *
+     * @return 저장했으면 true, spill도 가득 찼거나 예비 segment가 없으면 false.
+     */
+    bool SpillRingBuffer::push(int item) noexcept {
+
+        // spill이 비어 있을 때만 메모리 버퍼에 쓸 수 있다. 그렇지 않으면 spill의 데이터보다 먼저 읽힌다.
+        if (_spilledCount == 0 && _front - _back < BUFFER_SIZE) {
+            _pBuffer[_front % BUFFER_SIZE] = item;
+            ++_front;
+            return true;
+        }
+
+        if (!canSpill())
+            return false;
+
+        if (_spill.empty() || _spill.back()->writePos == SEGMENT_ITEMS) {
+            Segment* pSegment = acquireSegment();
+            if (pSegment == nullptr)
+                return false;
+            _spill.push_back(pSegment);
+        }
+
+        Segment* pTail = _spill.back();
+        pTail->pData[pTail->writePos++] = item;
+        ++_spilledCount;
+
+        return true;
+    }
+
+
+    /**
+     * @brief 메모리 버퍼를 먼저 읽고, 비어 있으면 가장 오래된 segment를 읽는다.
+     * _mutex를 잡은 상태에서 비어 있지 않을 때만 호출해야 한다.
+     */
+    int SpillRingBuffer::pop() noexcept {
+
+        if (_front != _back) {
+            int item = _pBuffer[_back % BUFFER_SIZE];
+            ++_back;
+            return item;
+        }
+
+        Segment* pHead = _spill.front();
+        int item = pHead->pData[pHead->readPos++];
+        --_spilledCount;
+
+        // 끝까지 읽었거나, 마지막 segment를 모두 읽어 spill이 비었으면 돌려준다.
+        if (pHead->readPos == SEGMENT_ITEMS || pHead->readPos == pHead->writePos) {
+            _spill.pop_front();
+            recycleSegment(pHead);
+        }
+
+        return item;
+    }
+
+
+    /**
+     * @brief 메모리 버퍼가 가득 차면 spill에 저장한다. spill도 최대 크기이면 값을 쓰지 않는다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void SpillRingBuffer::put(int item) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (!push(item)) {
+            ++_droppedCount;
+            return;
+        }
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+
+    /**
+     * @brief put과 같지만 spill도 최대 크기이면 빈 공간이 생길때까지 대기한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void SpillRingBuffer::putWithoutOverride(int item) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        while (!push(item))
+            _notFull.wait(lock);
+        /* Critical section end */
+
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+
+    /**
+     * @brief get()과 같지만 버퍼가 비어 있으면 예외 대신 false를 반환한다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼냈으면 true, 메모리 버퍼와 spill이 모두 비어 있으면 false.
+     */
+    bool SpillRingBuffer::tryGet(int& item) noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        if (isEmpty())
+            return false;
+
+        item = pop();
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_one();
+
+        return true;
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int SpillRingBuffer::get() {
+
+        int item;
+
+        if (!tryGet(item))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int SpillRingBuffer::getFromNotEmptyBuffer() noexcept {
+
+        unique_lock<mutex> lock(_mutex);
+
+        /* Critical section start */
+        _notEmpty.wait(lock, [this]() { return !isEmpty(); });
+
+        int item = pop();
+        /* Critical section end */
+
+        lock.unlock();
+        _notFull.notify_one();
+
+        return item;
+    }
+
+
+    /**
+     * @brief spill에 남아 있는 데이터 개수.
+     */
+    size_t SpillRingBuffer::spilled() noexcept {
+        lock_guard<mutex> lock(_mutex);
+        return _spilledCount;
+    }
+
+
+    /**
+     * @brief spill도 가득 차서 버린 데이터의 총 개수.
+     */
+    size_t SpillRingBuffer::dropped() noexcept {
+        lock_guard<mutex> lock(_mutex);
+        return _droppedCount;
+    }
+
+}; // rtos
@@ -0,0 +1,104 @@
+/**
+ * @file spillringbuffer.h
+ * @brief RingBuffer that spills overflow to memory-mapped segment files instead of dropping it
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _SPILL_RING_BUFFER_H_
+#define _SPILL_RING_BUFFER_H_
+
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief 메모리 버퍼가 가득 차면 넘치는 데이터를 파일에 저장하는 RingBuffer.
+     *
+     * 넘친 데이터는 directory에 만든 고정 크기 segment 파일에 순서대로 이어 쓴다. segment는 mmap으로
+     * 연결되어 있으므로 저장은 memcpy와 같고, 만들 때 page를 미리 읽어 두어 producer가 disk I/O를 기다리지 않는다.
+     * 파일을 만들고 닫는 일은 lock 밖에서 관리 쓰레드가 한다. 생성자가 예비 segment를 미리 만들고,
+     * 예비 segment를 사용하면 관리 쓰레드가 새로 만들어 채운다. 예비 segment가 없으면 spill할 수 없다.
+     * 파일은 만든 직후 이름을 지우므로 프로세스가 종료되면 자동으로 사라진다.
+     *
+     * FIFO 순서를 지키기 위해 spill에 데이터가 남아 있는 동안에는 새 데이터도 spill에 쓴다.
+     * consumer는 메모리 버퍼를 먼저 비운 뒤 spill을 오래된 segment부터 읽고, spill이 비면 다시 메모리 버퍼만 사용한다.
+     * 다 읽은 segment는 재사용 목록으로 돌려준다.
+     *
+     * segment 개수(예비 포함)는 maxSegments를 넘지 않는다. spill할 수 없으면 put은 데이터를 버리고(dropped로 기록)
+     * putWithoutOverride는 기다린다.
+     */
+    class SpillRingBuffer {
+
+        private:
+            struct Segment {
+                int fd;
+                int* pData;
+                size_t readPos; // 다음에 읽을 위치
+                size_t writePos; // 다음에 쓸 위치
+            };
+
+            int* _pBuffer;
+            const size_t BUFFER_SIZE;
+            size_t _front; // 지금까지 메모리 버퍼에 저장된 데이터 개수
+            size_t _back; // 지금까지 메모리 버퍼에서 꺼낸 데이터 개수
+
+            const string _directory;
+            const size_t SEGMENT_ITEMS; // segment 하나에 저장하는 데이터 개수
+            const size_t MAX_SEGMENTS;
+            deque<Segment*> _spill; // 사용 중인 segment. 앞에서 읽고 뒤에 쓴다.
+            vector<Segment*> _spares; // 재사용할 segment. 관리 쓰레드가 채운다.
+            vector<Segment*> _retired; // 관리 쓰레드가 닫을 segment
+            size_t _spilledCount; // spill에 남아 있는 데이터 개수
+            size_t _droppedCount;
+
+            mutex _mutex;
+            condition_variable _notEmpty;
+            condition_variable _notFull;
+            condition_variable _maintenance; // 관리 쓰레드를 깨운다.
+            bool _isStopping;
+            thread _maintainer;
+
+            Segment* createSegment();
+            void destroySegment(Segment* pSegment) noexcept;
+            bool needsSpare() const noexcept;
+            void maintain() noexcept;
+            Segment* acquireSegment() noexcept;
+            void recycleSegment(Segment* pSegment) noexcept;
+            bool isEmpty() const noexcept;
+            bool canSpill() const noexcept;
+            bool push(int item) noexcept;
+            int pop() noexcept;
+
+        public:
+            SpillRingBuffer(size_t n, const string& directory,
+                size_t segmentItems = 64 * 1024, size_t maxSegments = 64);
+            ~SpillRingBuffer();
+
+            SpillRingBuffer(const SpillRingBuffer&) = delete;
+            SpillRingBuffer& operator=(const SpillRingBuffer&) = delete;
+
+            void put (int item) noexcept;
+            void putWithoutOverride (int item) noexcept;
+            int get();
+            int getFromNotEmptyBuffer () noexcept;
+            bool tryGet (int& item) noexcept;
+
+            size_t spilled () noexcept;
+            size_t dropped () noexcept;
+
+    }; // SpillRingBuffer
+
+}; // rtos
+
+#endif // _SPILL_RING_BUFFER_H_
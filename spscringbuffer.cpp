@@ -0,0 +1,212 @@
+/**
+ * @file spscringbuffer.cpp
+ * @brief Lock-free single-producer/single-consumer RingBuffer implementation
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <thread>
+#include <algorithm>
+
+#include "spscringbuffer.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief Default Constructor which creates a buffer of length 10.
+     */
+    SpscRingBuffer::SpscRingBuffer(): SpscRingBuffer(10) {
+    }
+
+
+    /**
+     * @brief Creates a ring buffer of length n.
+     *
+     * @param n Buffer size.
+     */
+    SpscRingBuffer::SpscRingBuffer(size_t n): BUFFER_SIZE(n) {
+        _pBuffer = new int[BUFFER_SIZE];
+        _front.store(0, memory_order_relaxed);
+        _back.store(0, memory_order_relaxed);
+        _cachedBack = 0;
+        _cachedFront = 0;
+    }
+
+
+    SpscRingBuffer::~SpscRingBuffer() {
+        delete [] _pBuffer;
+    }
+
+
+    /**
+     * @brief Producer 쪽에서 빈 공간이 있으면 값을 저장한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     *
+     * @return 저장에 성공하면 true, 버퍼가 가득 찼으면 false.
+     */
+    bool SpscRingBuffer::push(int item) noexcept {
+
+        size_t front = _front.load(memory_order_relaxed);
+
+        if (front - _cachedBack == BUFFER_SIZE) {
+            // 가득 차 보일 때만 consumer의 index를 다시 읽는다.
+            _cachedBack = _back.load(memory_order_acquire);
+            if (front - _cachedBack == BUFFER_SIZE)
+                return false;
+        }
+
+        _pBuffer[front % BUFFER_SIZE] = item;
+        _front.store(front + 1, memory_order_release);
+
+        return true;
+    }
+
+
+    /**
+     * @brief Consumer 쪽에서 저장된 값이 있으면 꺼낸다.
+     *
+     * @param item 꺼낸 데이터를 저장할 변수.
+     *
+     * @return 꺼내는 데 성공하면 true, 버퍼가 비어 있으면 false.
+     */
+    bool SpscRingBuffer::pop(int& item) noexcept {
+
+        size_t back = _back.load(memory_order_relaxed);
+
+        if (back == _cachedFront) {
+            // 비어 보일 때만 producer의 index를 다시 읽는다.
+            _cachedFront = _front.load(memory_order_acquire);
+            if (back == _cachedFront)
+                return false;
+        }
+
+        item = _pBuffer[back % BUFFER_SIZE];
+        _back.store(back + 1, memory_order_release);
+
+        return true;
+    }
+
+
+    /**
+     * @brief 버퍼에 빈 공간이 없으면 값을 쓰지 않는다.
+     *
+     * @param item 버퍼에 저장할 새로운 데이터.
+     */
+    void SpscRingBuffer::put(int item) noexcept {
+        push(item);
+    }
+
+
+    /**
+     * @brief 데이터를 덮어쓰지 않고 빈 공간이 생길때까지 대기한다.
+     *
+     * @param item 버퍼에 저장할 데이터.
+     */
+    void SpscRingBuffer::putWithoutOverride(int item) noexcept {
+        while (!push(item))
+            this_thread::yield();
+    }
+
+
+    /**
+     * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int SpscRingBuffer::get() {
+
+        int item;
+
+        if (!pop(item))
+            throw EmptyBufferReadException();
+
+        return item;
+    }
+
+
+    /**
+     * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+     *
+     * @return 버퍼의 데이터.
+     */
+    int SpscRingBuffer::getFromNotEmptyBuffer() noexcept {
+
+        int item;
+
+        while (!pop(item))
+            this_thread::yield();
+
+        return item;
+    }
+
+
+    /**
+     * @brief Producer가 직접 쓸 수 있는 연속된 빈 공간을 얻는다.
+     * 끝에서 처음으로 넘어가는 부분은 포함하지 않으므로 나머지는 commit 후 다시 reserve한다.
+     *
+     * @param region 빈 공간의 시작 주소를 저장할 변수.
+     *
+     * @return 쓸 수 있는 데이터 개수. 버퍼가 가득 찼으면 0.
+     */
+    size_t SpscRingBuffer::reserve(int*& region) noexcept {
+
+        size_t front = _front.load(memory_order_relaxed);
+        size_t offset = front % BUFFER_SIZE;
+
+        // 사본 기준의 빈 공간이 연속 구간보다 작을 때만 consumer의 index를 다시 읽는다.
+        if (BUFFER_SIZE - (front - _cachedBack) < BUFFER_SIZE - offset)
+            _cachedBack = _back.load(memory_order_acquire);
+
+        size_t free = BUFFER_SIZE - (front - _cachedBack);
+        region = _pBuffer + offset;
+
+        return min(free, BUFFER_SIZE - offset);
+    }
+
+
+    /**
+     * @brief reserve로 얻은 공간 중 앞의 n개를 consumer에게 넘긴다.
+     *
+     * @param n 채운 데이터 개수. 직전 reserve의 반환값보다 클 수 없다.
+     */
+    void SpscRingBuffer::commit(size_t n) noexcept {
+        _front.store(_front.load(memory_order_relaxed) + n, memory_order_release);
+    }
+
+
+    /**
+     * @brief Consumer가 직접 읽을 수 있는 연속된 데이터 영역을 얻는다. 데이터는 꺼내지 않는다.
+     *
+     * @param region 데이터 영역의 시작 주소를 저장할 변수.
+     *
+     * @return 읽을 수 있는 데이터 개수. 버퍼가 비어 있으면 0.
+     */
+    size_t SpscRingBuffer::peek(const int*& region) noexcept {
+
+        size_t back = _back.load(memory_order_relaxed);
+        size_t offset = back % BUFFER_SIZE;
+
+        if (_cachedFront - back < BUFFER_SIZE - offset)
+            _cachedFront = _front.load(memory_order_acquire);
+
+        size_t available = _cachedFront - back;
+        region = _pBuffer + offset;
+
+        return min(available, BUFFER_SIZE - offset);
+    }
+
+
+    /**
+     * @brief peek로 얻은 영역 중 앞의 n개를 꺼낸 것으로 처리하여 producer에게 돌려준다.
+     *
+     * @param n 처리한 데이터 개수. 직전 peek의 반환값보다 클 수 없다.
+     */
+    void SpscRingBuffer::release(size_t n) noexcept {
+        _back.store(_back.load(memory_order_relaxed) + n, memory_order_release);
+    }
+
+}; // rtos
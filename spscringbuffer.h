@@ -0,0 +1,73 @@
+/**
+ * @file spscringbuffer.h
+ * @brief Lock-free single-producer/single-consumer RingBuffer interface
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _SPSC_RING_BUFFER_H_
+#define _SPSC_RING_BUFFER_H_
+
+#include <cstddef>
+#include <atomic>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    /**
+     * @brief Producer와 Consumer가 각각 하나인 경우에 사용하는 lock-free RingBuffer.
+     *
+     * RingBuffer와 동일한 인터페이스와 의미(가득 찬 경우 put은 no-op, 빈 버퍼에서 get은 예외)를
+     * 가지지만 mutex 대신 acquire/release atomic으로 동기화한다.
+     * _front는 producer만, _back은 consumer만 갱신하며 서로 다른 cache line에 배치한다.
+     * 각 쪽은 상대방 index의 사본(_cachedBack, _cachedFront)을 두고
+     * 버퍼가 가득 찼거나 비어 보일 때만 상대방의 cache line을 읽는다.
+     *
+     * reserve/commit, peek/release를 사용하면 producer는 버퍼에 직접 쓰고
+     * consumer는 버퍼를 직접 읽으므로 중간 복사가 없다.
+     */
+    class SpscRingBuffer {
+
+        private:
+            int* _pBuffer;
+            const size_t BUFFER_SIZE;
+
+            // producer 전용 cache line
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _front; // 지금까지 저장된 데이터 개수
+            size_t _cachedBack;
+
+            // consumer 전용 cache line
+            alignas(CACHE_LINE_SIZE) atomic<size_t> _back; // 지금까지 꺼낸 데이터 개수
+            size_t _cachedFront;
+
+            char _padding[CACHE_LINE_SIZE - sizeof(atomic<size_t>) - sizeof(size_t)];
+
+            bool push(int item) noexcept;
+            bool pop(int& item) noexcept;
+
+        public:
+            SpscRingBuffer();
+            SpscRingBuffer(size_t n);
+            ~SpscRingBuffer();
+
+            SpscRingBuffer(const SpscRingBuffer&) = delete;
+            SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+            void put (int item) noexcept;
+            void putWithoutOverride (int item) noexcept;
+            int get();
+            int getFromNotEmptyBuffer () noexcept;
+
+            size_t reserve (int*& region) noexcept;
+            void commit (size_t n) noexcept;
+            size_t peek (const int*& region) noexcept;
+            void release (size_t n) noexcept;
+
+    }; // SpscRingBuffer
+
+}; // rtos
+
+#endif // _SPSC_RING_BUFFER_H_
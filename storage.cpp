@@ -0,0 +1,189 @@
+/**
+ * @file storage.cpp
+ * @brief Slot storage allocation with alignment, huge-page, NUMA and mlock options
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+    #include <sys/syscall.h>
+    #include <linux/mempolicy.h>
+#endif
+
+#include "storage.h"
+
+
+namespace rtos {
+
+
+    /**
+     * @brief options에 따라 bytes 크기의 공간을 할당한다. 적용하지 못한 옵션이 있으면 StorageException을 던진다.
+     *
+     * @param bytes 필요한 크기
+     * @param options 할당 방법
+     */
+    SlotStorage::SlotStorage(size_t bytes, const StorageOptions& options):
+        _pData(nullptr), _size(0), _isMapped(false), _isHugePage(false), _isLocked(false),
+        _pAllocator(options.pAllocator) {
+
+        allocate(max(bytes, (size_t)1), options);
+
+        try {
+            if (options.numaNode != ANY_NUMA_NODE && _pAllocator == nullptr)
+                bind(options.numaNode);
+
+            // 실행 중에 page fault가 일어나지 않도록 모든 page를 미리 쓴다.
+            if (options.prefault)
+                memset(_pData, 0, _size);
+
+            if (options.lock) {
+                if (mlock(_pData, _size) < 0)
+                    throw StorageException(string("mlock: ") + strerror(errno));
+                _isLocked = true;
+            }
+        }
+        catch (...) {
+            release();
+            throw;
+        }
+    }
+
+
+    SlotStorage::~SlotStorage() {
+        release();
+    }
+
+
+    void SlotStorage::allocate(size_t bytes, const StorageOptions& options) {
+
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t alignment = max(options.alignment, sizeof(void*));
+
+        if (_pAllocator != nullptr) {
+            _size = bytes;
+            _pData = _pAllocator->allocate(_size, alignment);
+            if (_pData == nullptr)
+                throw StorageException("StorageAllocator failed to allocate");
+            return;
+        }
+
+        // NUMA binding은 page 단위로 적용되므로 다른 할당과 page를 공유하지 않도록 mmap을 사용한다.
+        if (!options.hugePages && options.numaNode == ANY_NUMA_NODE && alignment <= page) {
+            _size = bytes;
+            if (posix_memalign(&_pData, alignment, _size) != 0)
+                throw StorageException("posix_memalign failed");
+            return;
+        }
+
+        if (alignment > page && !options.hugePages)
+            throw StorageException("alignment larger than a page requires hugePages");
+
+        _isMapped = true;
+
+        if (options.hugePages) {
+            _size = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+            // 예약된 huge page(hugetlbfs)를 먼저 시도한다.
+            _pData = mmap(nullptr, _size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (_pData != MAP_FAILED) {
+                _isHugePage = true;
+                return;
+            }
+#endif
+            // 없으면 huge page 경계에 맞춘 영역을 잡고 transparent huge page를 요청한다.
+            size_t reserved = _size + HUGE_PAGE_SIZE;
+            char* base = static_cast<char*>(mmap(nullptr, reserved, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (base == MAP_FAILED)
+                throw StorageException(string("mmap: ") + strerror(errno));
+
+            size_t head = (HUGE_PAGE_SIZE - (size_t)base % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+            if (head > 0)
+                munmap(base, head);
+            munmap(base + head + _size, reserved - head - _size);
+            _pData = base + head;
+#ifdef MADV_HUGEPAGE
+            _isHugePage = (madvise(_pData, _size, MADV_HUGEPAGE) == 0);
+#endif
+            return;
+        }
+
+        _size = (bytes + page - 1) / page * page;
+        _pData = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (_pData == MAP_FAILED) {
+            _pData = nullptr;
+            throw StorageException(string("mmap: ") + strerror(errno));
+        }
+    }
+
+
+    /**
+     * @brief 저장 공간을 node의 메모리에만 배치한다. 이미 다른 node에 할당된 page는 옮긴다.
+     */
+    void SlotStorage::bind(int node) {
+#ifdef __linux__
+        const size_t BITS = 8 * sizeof(unsigned long);
+        unsigned long mask[16] = { 0 };
+
+        if (node < 0 || (size_t)node >= BITS * 16)
+            throw StorageException("invalid NUMA node");
+        mask[node / BITS] = 1UL << (node % BITS);
+
+        if (syscall(SYS_mbind, _pData, _size, MPOL_BIND, mask, BITS * 16, MPOL_MF_MOVE) < 0)
+            throw StorageException(string("mbind: ") + strerror(errno));
+#else
+        throw StorageException("NUMA binding is not supported");
+#endif
+    }
+
+
+    void SlotStorage::release() noexcept {
+
+        if (_pData == nullptr)
+            return;
+
+        if (_isLocked)
+            munlock(_pData, _size);
+
+        if (_pAllocator != nullptr)
+            _pAllocator->deallocate(_pData, _size);
+        else if (_isMapped)
+            munmap(_pData, _size);
+        else
+            free(_pData);
+
+        _pData = nullptr;
+    }
+
+
+    void* SlotStorage::data() const noexcept {
+        return _pData;
+    }
+
+
+    size_t SlotStorage::size() const noexcept {
+        return _size;
+    }
+
+
+    /**
+     * @brief huge page로 할당했거나 transparent huge page 요청이 받아들여졌으면 true.
+     */
+    bool SlotStorage::isHugePage() const noexcept {
+        return _isHugePage;
+    }
+
+
+    bool SlotStorage::isLocked() const noexcept {
+        return _isLocked;
+    }
+
+}; // rtos
@@ -0,0 +1,119 @@
+/**
+ * @file storage.h
+ * @brief Slot storage allocation with alignment, huge-page, NUMA and mlock options
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _STORAGE_H_
+#define _STORAGE_H_
+
+#include <cstddef>
+#include <string>
+#include <exception>
+
+using namespace std;
+
+namespace rtos {
+
+    const size_t CACHE_LINE_SIZE = 64; // false sharing을 피하기 위한 정렬 단위
+    const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024; // x86-64, ARM64의 기본 huge page 크기
+    const int ANY_NUMA_NODE = -1;
+
+
+    /**
+     * @brief 버퍼의 저장 공간을 할당하는 방법을 바꾸고 싶을 때 상속한다.
+     * StorageOptions::pAllocator로 전달하며, 버퍼보다 오래 살아 있어야 한다.
+     */
+    class StorageAllocator {
+
+        public:
+            virtual ~StorageAllocator() {}
+
+            /**
+             * @brief alignment 단위로 정렬된 bytes 크기의 공간을 할당한다. 실패하면 nullptr를 반환한다.
+             */
+            virtual void* allocate(size_t bytes, size_t alignment) noexcept = 0;
+            virtual void deallocate(void* p, size_t bytes) noexcept = 0;
+
+    }; // StorageAllocator
+
+
+    /**@struct StorageOptions
+     * @brief 저장 공간 할당 방법.
+     * @var StorageOptions::alignment
+     * 시작 주소의 정렬 단위. 2의 거듭제곱이어야 한다.
+     * @var StorageOptions::hugePages
+     * huge page를 사용한다. 예약된 huge page가 없으면 transparent huge page를 요청한다.
+     * @var StorageOptions::numaNode
+     * 지정한 NUMA node의 메모리만 사용한다. ANY_NUMA_NODE이면 지정하지 않는다.
+     * @var StorageOptions::prefault
+     * 생성할 때 모든 page에 미리 접근하여 실행 중에 page fault가 일어나지 않게 한다.
+     * @var StorageOptions::lock
+     * mlock으로 저장 공간이 swap되지 않게 한다.
+     * @var StorageOptions::pAllocator
+     * 지정하면 위의 방법 대신 이 allocator로 할당한다. alignment, prefault, lock만 적용된다.
+     */
+    typedef struct storage_options {
+        size_t alignment = CACHE_LINE_SIZE;
+        bool hugePages = false;
+        int numaNode = ANY_NUMA_NODE;
+        bool prefault = false;
+        bool lock = false;
+        StorageAllocator* pAllocator = nullptr;
+    } StorageOptions;
+
+
+    /**
+     * @brief StorageOptions에 따라 할당한 연속된 저장 공간. 소멸할 때 해제한다.
+     *
+     * 별다른 옵션이 없으면 정렬된 heap 메모리를 사용하고, huge page나 NUMA node를 지정하거나
+     * page 이상의 정렬이 필요하면 anonymous mmap을 사용한다. 요청한 옵션을 적용하지 못하면
+     * StorageException을 던진다. 단, huge page는 가능한 방법으로 시도하고 결과를 isHugePage()로 알려준다.
+     */
+    class SlotStorage {
+
+        private:
+            void* _pData;
+            size_t _size; // 할당한 크기. mmap이면 page 크기의 배수
+            bool _isMapped;
+            bool _isHugePage;
+            bool _isLocked;
+            StorageAllocator* _pAllocator;
+
+            void allocate(size_t bytes, const StorageOptions& options);
+            void bind(int node);
+            void release() noexcept;
+
+        public:
+            SlotStorage(size_t bytes, const StorageOptions& options);
+            ~SlotStorage();
+
+            SlotStorage(const SlotStorage&) = delete;
+            SlotStorage& operator=(const SlotStorage&) = delete;
+
+            void* data() const noexcept;
+            size_t size() const noexcept;
+            bool isHugePage() const noexcept;
+            bool isLocked() const noexcept;
+
+    }; // SlotStorage
+
+
+    class StorageException : public exception {
+
+        private:
+            const string _message;
+
+        public:
+            explicit StorageException(const string& message): _message(message) {}
+
+            const char* what() const throw() {
+                return _message.c_str();
+            }
+
+    }; // StorageException
+
+}; // rtos
+
+#endif // _STORAGE_H_
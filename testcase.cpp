@@ -19,8 +19,13 @@
 #include <unistd.h>
 #include <chrono>
 #include <random>
+#include <atomic>
+#include <cstring>
+#include <cstdarg>
 
 #include "ringbuffer.h"
+#include "recordringbuffer.h"
+#include "simulator.h"
 
 
 using namespace rtos;
@@ -72,7 +77,14 @@ namespace SIMUL_PARAM {
     const int TC_PROD_NUM = 1;
     const int TC_CONS_NUM = 1;
 
-    const size_t MSG_LENGTH = 80;
+    const size_t MSG_LENGTH = 128; // 메세지 하나의 최대 길이
+    const size_t MSG_RING_SIZE = 64 * 1024; // 출력할 메세지를 저장하는 버퍼의 크기 (bytes)
+    const size_t OUTPUT_BATCH_SIZE = 8 * 1024; // observer가 한 번에 출력하는 최대 크기 (bytes)
+
+    // 가상 시간 시뮬레이션 (option s)
+    const double SWEEP_DURATION = 600000.0; // 가상 시간으로 진행할 시간 (milliseconds)
+    const size_t SWEEP_BUFFER_SIZES[] = { 1, 2, 5, 10, 20, 50, 100 };
+    const uint64_t SWEEP_SEED = 1;
 
 }; // SIMUL_PARAM
 
@@ -84,14 +96,14 @@ void* produce(void*); // Body of producer thread.
 void* consume(void*); // Body of consumer thread.
 void* observe(void*); // Body of observer thread.
 
-size_t miss = 0; // 빈 버퍼에 접근한 횟수
-size_t accessCount = 0; // 처리기가 버퍼에 접근한 횟수
-int loss = 0; // 손실된 데이터 개수
-int produceCount = 0; // 생성기가 생성한 데이터 개수
-void testbody(period, period, size_t, size_t, queue<char*>&, mutex&);
-void testcaseA(queue<char*>&, mutex&); // Data의 평균 발생속도 < 평균 처리속도
-void testcaseB(queue<char*>&, mutex&); // Data의 평균 발생속도 = 평균 처리속도
-void testcaseC(queue<char*>&, mutex&); // Data의 평균 발생속도 > 평균 처리속도
+atomic<size_t> traceDropCount(0); // 메세지 버퍼가 가득 차서 출력하지 못한 메세지 개수
+pthread_t observer;
+void trace(RecordRingBuffer*, const char*, ...);
+void testbody(period, period, size_t, size_t, RecordRingBuffer&);
+void testcaseA(RecordRingBuffer&); // Data의 평균 발생속도 < 평균 처리속도
+void testcaseB(RecordRingBuffer&); // Data의 평균 발생속도 = 평균 처리속도
+void testcaseC(RecordRingBuffer&); // Data의 평균 발생속도 > 평균 처리속도
+void simulateSweep(); // 가상 시간으로 a, b, c의 버퍼 크기별 결과를 계산한다.
 void printUsage();
 
 
@@ -106,38 +118,32 @@ int main(int argc, char* argv[]) {
 
     // Execute observer.
     // Observer thread print messages to stdout.
-    queue<char*> msgq;
-    mutex msgMutex;
+    RecordRingBuffer msgRing(SIMUL_PARAM::MSG_RING_SIZE);
     ObserverArgs* pObserverArgs = new ObserverArgs; //TODO 메모리 해제 안 했음
-    pObserverArgs->pMsgqMutex = &msgMutex;
-    pObserverArgs->pMsgq = &msgq;
-    pthread_t observer;
+    pObserverArgs->pMsgRing = &msgRing;
 
     char testcaseNum = (char)(*argv[1]);
+    if (testcaseNum == 's') {
+        simulateSweep();
+        return 0;
+    }
+
     switch (testcaseNum) {
         case 'a':
-            pObserverArgs->counter =
-                (SIMUL_PARAM::TA_CONS_NUM + SIMUL_PARAM::TA_PROD_NUM) * (SIMUL_PARAM::SAMPLE_SIZE);
             pthread_create(&observer, NULL, observe, (void*)(pObserverArgs));
-            testcaseA(msgq, msgMutex);
+            testcaseA(msgRing);
             break;
         case 'b':
-            pObserverArgs->counter =
-                (SIMUL_PARAM::TB_CONS_NUM + SIMUL_PARAM::TB_PROD_NUM) * (SIMUL_PARAM::SAMPLE_SIZE);
             pthread_create(&observer, NULL, observe, (void*)(pObserverArgs));
-            testcaseB(msgq, msgMutex);
+            testcaseB(msgRing);
             break;
         case 'c':
-            pObserverArgs->counter =
-                (SIMUL_PARAM::TC_CONS_NUM + SIMUL_PARAM::TC_PROD_NUM) * (SIMUL_PARAM::SAMPLE_SIZE);
             pthread_create(&observer, NULL, observe, (void*)(pObserverArgs));
-            testcaseC(msgq, msgMutex);
+            testcaseC(msgRing);
             break;
         default: printUsage(); break;
     }
 
-    pthread_join(observer, NULL);
-
     return 0;
 }
 
@@ -150,6 +156,7 @@ void printUsage() {
     cout << "a: 평균처리속도가 평균발생속도보다 빠른 경우\n";
     cout << "b: 평균처리속도와 평균발생속도보다 같은 경우\n";
     cout << "c: 평균처리속도가 평균발생속도보다 느린 경우\n";
+    cout << "s: a, b, c를 가상 시간으로 버퍼 크기별로 시뮬레이션\n";
     cout << "ctrl-c: 프로그램 종료\n";
 }
 
@@ -207,56 +214,35 @@ void* consume(void* param) {
     size_t threadNum = pArgs->threadNum;
     RingBuffer* pBuffer = pArgs->pRingBuffer;
     period t = pArgs->interval;
-    queue<char*>* pMsgq = pArgs->pMsgq;
-    mutex* pMsgqMutex = pArgs->pMsgqMutex;
+    RecordRingBuffer* pMsgRing = pArgs->pMsgRing;
     period* pDistribution = pArgs->pDistribution;
 
-    int last_data = 0; // 마지막으로 처리한 데이터 (loss 계산에 사용)
-
     size_t i = 0;
     while (elapsedtime() < SIMUL_PARAM::DURATION) {
         this_thread::sleep_for(chrono::milliseconds(pDistribution[i]));
-        char* pMsgbuff = new char[SIMUL_PARAM::MSG_LENGTH];
-
-        accessCount += 1;
-        try {
-            int data = pBuffer->get();
-
-            // loss 계산
-            if (last_data + 1 < data)
-                loss += (data - last_data - 1);
-            last_data = data;
 
-            sprintf(pMsgbuff,"[timestamp:%07dms] %s[Consumer%2zu] 소비한 데이터: %d%s\n",
+        int data;
+        if (pBuffer->tryGet(data)) {
+            trace(pMsgRing, "[timestamp:%07dms] %s[Consumer%2zu] 소비한 데이터: %d%s\n",
                 elapsedtime(),
                 ANSI_CONTROL::BLUE,
                 threadNum,
                 data,
                 ANSI_CONTROL::DEFAULT);
         }
-        catch (const EmptyBufferReadException& e) {
-            sprintf(pMsgbuff, "[timestamp:%07dms] %s[Consumer%2zu] %s%s\n",
+        else {
+            // 빈 버퍼에 접근한 경우. 예외를 던지는 get() 대신 tryGet()으로 확인한다.
+            trace(pMsgRing, "[timestamp:%07dms] %s[Consumer%2zu] %s%s\n",
                 elapsedtime(),
                 ANSI_CONTROL::BLUE,
                 threadNum,
-                e.what(),
+                EmptyBufferReadException().what(),
                 ANSI_CONTROL::DEFAULT);
-            miss++;
-
         }
 
-        // 출력 메세지 저장
-        unique_lock<mutex> msgqLock(*pMsgqMutex);
-        /* Critical section start */
-        pMsgq->push(pMsgbuff);
-        /* Critical section end */
-        msgqLock.unlock();
-
         i = (i+1) % SIMUL_PARAM::SAMPLE_SIZE;
     }
 
-    // loss += (SIMUL_PARAM::SAMPLE_SIZE - 1 - last_data);
-
     return nullptr;
 
 }
@@ -271,8 +257,7 @@ void* produce(void* param) {
     mutex* pMutex = pArgs->pMutex;
     RingBuffer* pBuffer = pArgs->pRingBuffer;
     period t = pArgs->interval;
-    queue<char*>* pMsgq = pArgs->pMsgq;
-    mutex* pMsgqMutex = pArgs->pMsgqMutex;
+    RecordRingBuffer* pMsgRing = pArgs->pMsgRing;
     period* pDistribution = pArgs->pDistribution;
 
     size_t i = 0;
@@ -283,26 +268,16 @@ void* produce(void* param) {
         /* Critical section start */
         int data = (*pData);
         pBuffer->put((*pData)++);
-        produceCount += 1;
         /* Critical section end */
         lock.unlock();
 
-        char* pMsgbuff = new char[SIMUL_PARAM::MSG_LENGTH];
-        elapsedtime();
-        sprintf(pMsgbuff, "[timestamp:%07dms] %s[Producer%2zu] 생성한 데이터: %d%s\n",
+        trace(pMsgRing, "[timestamp:%07dms] %s[Producer%2zu] 생성한 데이터: %d%s\n",
             elapsedtime(),
             ANSI_CONTROL::GREEN,
             threadNum,
             data,
             ANSI_CONTROL::DEFAULT);
 
-        // 출력 메세지 저장
-        unique_lock<mutex> msgqLock(*pMsgqMutex);
-        /* Critical section start */
-        pMsgq->push(pMsgbuff);
-        /* Critical section end */
-        msgqLock.unlock();
-
         i = (i + 1) % SIMUL_PARAM::SAMPLE_SIZE;
     }
     
@@ -313,36 +288,71 @@ void* produce(void* param) {
 
 
 /**
- * @brief 큐에 저장된 메세지를 출력한다.
+ * @brief 메세지를 만들어 observer에게 전달한다. heap 할당이 없고 기다리지 않는다.
+ * 메세지 버퍼가 가득 차 있으면 메세지를 버리므로 측정 대상 쓰레드의 실행 시간에 영향을 주지 않는다.
+ *
+ * @param pMsgRing 메세지를 저장할 버퍼
+ * @param format printf 형식 문자열
+ */
+void trace(RecordRingBuffer* pMsgRing, const char* format, ...) {
+
+    char msg[SIMUL_PARAM::MSG_LENGTH];
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(msg, sizeof(msg), format, args);
+    va_end(args);
+
+    if (length < 0)
+        return;
+    if ((size_t)length >= sizeof(msg))
+        length = sizeof(msg) - 1;
+
+    if (!pMsgRing->put(msg, length))
+        traceDropCount++;
+}
+
+
+
+/**
+ * @brief 버퍼에 저장된 메세지를 출력한다.
+ * 메세지가 없으면 잠들고, 깨어나면 쌓인 메세지를 모아 한 번에 출력한다.
+ * 길이가 0인 메세지를 받으면 종료한다.
  *
  * @param param
- * queue<char*>* 메세지가 저장된 큐의 주소
+ * ObserverArgs* 메세지가 저장된 버퍼의 주소
  *
  * @return nullptr
  */
 void* observe(void* param) {
     
     ObserverArgs* pArgs = static_cast<ObserverArgs*>(param);
-    queue<char*>* pMsgq = pArgs->pMsgq;
-    mutex* pMsgqMutex = pArgs->pMsgqMutex;
+    RecordRingBuffer* pMsgRing = pArgs->pMsgRing;
 
-    char* msg = nullptr;
+    char batch[SIMUL_PARAM::OUTPUT_BATCH_SIZE];
+    bool running = true;
 
-    while (elapsedtime() < SIMUL_PARAM::DURATION + SIMUL_PARAM::DURATION_MARGIN) {
-         unique_lock<mutex> msgqLock(*pMsgqMutex);
-        /* Critical section start */
-        if (!pMsgq->empty()) {
-            msg = pMsgq->front();
-            pMsgq->pop();
-        }
-        /* Critical section end */
-        msgqLock.unlock();
+    while (running) {
+        size_t used = pMsgRing->getFromNotEmptyBuffer(batch, SIMUL_PARAM::MSG_LENGTH);
+        if (used == 0)
+            break;
 
-        if (msg != nullptr) {
-            printf("%s", msg);
-            delete[] msg;
-            msg = nullptr;
+        // 이미 쌓여 있는 메세지를 복사 없이 읽어 batch에 모은다.
+        size_t length;
+        const void* msg;
+        while (used + SIMUL_PARAM::MSG_LENGTH <= sizeof(batch)
+            && (msg = pMsgRing->peek(length)) != nullptr) {
+            if (length == 0)
+                running = false;
+            memcpy(batch + used, msg, length);
+            used += length;
+            pMsgRing->release();
+            if (!running)
+                break;
         }
+
+        fwrite(batch, 1, used, stdout);
+        fflush(stdout);
     }
 
     return nullptr;
@@ -356,7 +366,7 @@ void* observe(void* param) {
  * @param p Producer의 동작 주기
  */
 void testbody(period p, period c, size_t pn, size_t cn,
-    queue<char*>& msgq, mutex& msgqMutex) {
+    RecordRingBuffer& msgRing) {
     
     signal(SIGINT, sigintHandler);
 
@@ -376,6 +386,7 @@ void testbody(period p, period c, size_t pn, size_t cn,
     initThreadPeriod(consumerPeriod, SIMUL_PARAM::CONS_SIGMA, c);
 
     RingBuffer buffer(SIMUL_PARAM::BUFFER_SIZE);
+    buffer.enableLatencyTracing();
     mutex m;
     int item = 0;
     pthread_t producer;
@@ -389,8 +400,7 @@ void testbody(period p, period c, size_t pn, size_t cn,
         pProducerArgs->pMutex = &m;
         pProducerArgs->interval = p;
         pProducerArgs->pRingBuffer = &buffer;
-        pProducerArgs->pMsgq = &msgq;
-        pProducerArgs->pMsgqMutex = &msgqMutex;
+        pProducerArgs->pMsgRing = &msgRing;
         pProducerArgs->pDistribution = producerPeriod;
         pthread_create(&producer, NULL, produce, (void*)(pProducerArgs));
     }
@@ -403,8 +413,7 @@ void testbody(period p, period c, size_t pn, size_t cn,
         pConsumerArgs->pMutex = &m;
         pConsumerArgs->interval = c;
         pConsumerArgs->pRingBuffer = &buffer;
-        pConsumerArgs->pMsgq = &msgq;
-        pConsumerArgs->pMsgqMutex = &msgqMutex;
+        pConsumerArgs->pMsgRing = &msgRing;
         pConsumerArgs->pDistribution = consumerPeriod;
         pthread_create(&consumer, NULL, consume, (void*)(pConsumerArgs));
     }
@@ -415,6 +424,10 @@ void testbody(period p, period c, size_t pn, size_t cn,
     for (size_t i=0; i<cn; i++)
         pthread_join(consumer, NULL);
 
+    // 길이가 0인 메세지로 observer를 종료시키고, 남은 메세지가 모두 출력된 뒤 결과를 출력한다.
+    msgRing.putWithoutOverride("", 0);
+    pthread_join(observer, NULL);
+
     printf("\n시뮬레이션 진행 시간: %dms\n", SIMUL_PARAM::DURATION);
     printf("버퍼 크기: %d\n", SIMUL_PARAM::BUFFER_SIZE);
     printf("표본 크기: %d\n", SIMUL_PARAM::SAMPLE_SIZE);
@@ -422,43 +435,118 @@ void testbody(period p, period c, size_t pn, size_t cn,
     printf("Consumer의 데이터 소비주기 평균: %zums\n", c);
     printf("Producer의 데이터 생성주기 표준편차: %.2f\n", SIMUL_PARAM::PROD_SIGMA);
     printf("Consumer의 데이터 소비주기 표준편차: %.2f\n", SIMUL_PARAM::CONS_SIGMA);
-    // printf("%s빈 버퍼에 접근한 횟수: %zu%s\n", ANSI_CONTROL::CYAN, miss, ANSI_CONTROL::DEFAULT);
-    // printf("%s손실된 데이터 개수: %d%s\n\n", ANSI_CONTROL::CYAN, loss, ANSI_CONTROL::DEFAULT);
+
+    // 빈 버퍼 접근과 손실은 버퍼가 직접 기록한 지표로 계산한다.
+    RingBufferStats stats = buffer.stats();
     printf("%s빈 버퍼에 접근한 비율: %.2f%%%s\n",
         ANSI_CONTROL::CYAN,
-        static_cast<float>(miss)/static_cast<float>(accessCount)*100,
+        static_cast<float>(stats.emptyReads)/static_cast<float>(stats.emptyReads + stats.dequeues)*100,
         ANSI_CONTROL::DEFAULT);
-    printf("%s손실된 데이터 비율: %.2f%%%s\n\n",
+    printf("%s손실된 데이터 비율: %.2f%%%s\n",
         ANSI_CONTROL::CYAN,
-        static_cast<float>(loss)/static_cast<float>(produceCount)*100,
+        static_cast<float>(stats.droppedPuts)/static_cast<float>(stats.droppedPuts + stats.enqueues)*100,
         ANSI_CONTROL::DEFAULT);
+    printf("저장/소비/손실/빈 버퍼 접근: %llu/%llu/%llu/%llu\n",
+        (unsigned long long)stats.enqueues,
+        (unsigned long long)stats.dequeues,
+        (unsigned long long)stats.droppedPuts,
+        (unsigned long long)stats.emptyReads);
+    printf("최대 저장 개수: %llu, lock 경합 횟수: %llu\n",
+        (unsigned long long)stats.highWaterMark,
+        (unsigned long long)stats.lockContentions);
+
+    // 버퍼에 머문 시간. histogram 구간의 상한이므로 최대 2배까지 크게 나온다.
+    LatencyHistogram& latency = buffer.latency();
+    printf("버퍼 체류 시간(ms) 평균/p50/p99/최대: %.2f/%.2f/%.2f/%.2f\n\n",
+        latency.mean() / 1e6,
+        latency.percentile(0.5) / 1e6,
+        latency.percentile(0.99) / 1e6,
+        latency.max() / 1e6);
+    if (traceDropCount > 0)
+        printf("출력하지 못한 메세지 개수: %zu\n\n", traceDropCount.load());
 }
 
 
-void testcaseA(queue<char*>& msgq, mutex& msgqMutex) {
+void testcaseA(RecordRingBuffer& msgRing) {
 
     printf("tescase a\n");
     testbody(SIMUL_PARAM::TA_PROD_PERIOD, SIMUL_PARAM::TA_CONS_PERIOD,
         SIMUL_PARAM::TA_PROD_NUM, SIMUL_PARAM::TA_CONS_NUM,
-        msgq, msgqMutex);
+        msgRing);
 
 }
 
 
-void testcaseB(queue<char*>& msgq, mutex& msgqMutex) {
+void testcaseB(RecordRingBuffer& msgRing) {
 
     printf("tescase b\n");
     testbody(SIMUL_PARAM::TB_PROD_PERIOD, SIMUL_PARAM::TB_CONS_PERIOD,
         SIMUL_PARAM::TB_PROD_NUM, SIMUL_PARAM::TB_CONS_NUM,
-        msgq, msgqMutex);
+        msgRing);
 }
 
 
-void testcaseC(queue<char*>& msgq, mutex& msgqMutex) {
+void testcaseC(RecordRingBuffer& msgRing) {
 
     printf("tescase c\n");
     testbody(SIMUL_PARAM::TC_PROD_PERIOD, SIMUL_PARAM::TC_CONS_PERIOD,
         SIMUL_PARAM::TC_PROD_NUM, SIMUL_PARAM::TC_CONS_NUM,
-        msgq, msgqMutex);
+        msgRing);
+
+}
+
+
+
+/**
+ * @brief testcase a, b, c의 주기로 버퍼 크기를 바꾸어 가며 가상 시간 시뮬레이션을 하고 표로 출력한다.
+ * sleep 없이 실행되며 seed가 같으면 결과도 같다.
+ */
+void simulateSweep() {
+
+    const char names[] = { 'a', 'b', 'c' };
+    const period prodPeriods[] = { SIMUL_PARAM::TA_PROD_PERIOD, SIMUL_PARAM::TB_PROD_PERIOD, SIMUL_PARAM::TC_PROD_PERIOD };
+    const period consPeriods[] = { SIMUL_PARAM::TA_CONS_PERIOD, SIMUL_PARAM::TB_CONS_PERIOD, SIMUL_PARAM::TC_CONS_PERIOD };
+    const size_t prodNums[] = { SIMUL_PARAM::TA_PROD_NUM, SIMUL_PARAM::TB_PROD_NUM, SIMUL_PARAM::TC_PROD_NUM };
+    const size_t consNums[] = { SIMUL_PARAM::TA_CONS_NUM, SIMUL_PARAM::TB_CONS_NUM, SIMUL_PARAM::TC_CONS_NUM };
+
+    vector<size_t> bufferSizes(SIMUL_PARAM::SWEEP_BUFFER_SIZES,
+        SIMUL_PARAM::SWEEP_BUFFER_SIZES + sizeof(SIMUL_PARAM::SWEEP_BUFFER_SIZES) / sizeof(size_t));
+
+    printf("가상 시간: %.0fms, seed: %llu\n\n", SIMUL_PARAM::SWEEP_DURATION,
+        (unsigned long long)SIMUL_PARAM::SWEEP_SEED);
+    printf("%-4s %6s %10s %10s %10s %12s %12s\n",
+        "case", "size", "손실(%)", "빈 접근(%)", "평균 개수", "평균 대기ms", "최대 대기ms");
+
+    uint64_t events = 0;
+    auto start = chrono::steady_clock::now();
+
+    for (size_t i=0; i<3; ++i) {
+        SimulationConfig config;
+        config.producerPeriod.mean = prodPeriods[i];
+        config.producerPeriod.spread = SIMUL_PARAM::PROD_SIGMA;
+        config.consumerPeriod.mean = consPeriods[i];
+        config.consumerPeriod.spread = SIMUL_PARAM::CONS_SIGMA;
+        config.duration = SIMUL_PARAM::SWEEP_DURATION;
+        config.seed = SIMUL_PARAM::SWEEP_SEED;
+
+        vector<SimulationResult> results = Simulator::sweep(config, bufferSizes,
+            vector<size_t>(1, prodNums[i]), vector<size_t>(1, consNums[i]));
+
+        for (size_t j=0; j<results.size(); ++j) {
+            const SimulationResult& result = results[j];
+            printf("%-4c %6zu %10.2f %10.2f %10.2f %12.2f %12.2f\n",
+                names[i],
+                result.config.bufferSize,
+                result.lossRatio * 100,
+                result.emptyReadRatio * 100,
+                result.meanOccupancy,
+                result.meanLatency,
+                result.maxLatency);
+            events += result.events;
+        }
+    }
 
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    printf("\n%llu events, %.2fs (%.0f events/s)\n",
+        (unsigned long long)events, elapsed.count(), events / elapsed.count());
 }
@@ -0,0 +1,261 @@
+/**
+ * @file typedringbuffer.h
+ * @brief Header-only RingBuffer over an arbitrary element type
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _TYPED_RING_BUFFER_H_
+#define _TYPED_RING_BUFFER_H_
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <condition_variable>
+
+#include "ringbuffer.h"
+
+using namespace std;
+
+namespace rtos {
+
+    const size_t DYNAMIC_CAPACITY = 0; // 용량을 생성자에서 정한다.
+
+    namespace detail {
+
+        /**
+         * @brief 2의 거듭제곱인지 확인한다.
+         */
+        constexpr bool isPowerOfTwo(size_t n) {
+            return n != 0 && (n & (n - 1)) == 0;
+        }
+
+
+        /**
+         * @brief 용량이 컴파일 시간에 정해진 경우의 저장 공간. 원소들을 객체 안에 직접 저장한다.
+         */
+        template <typename T, size_t Capacity>
+        class RingStorage {
+
+            private:
+                typename aligned_storage<sizeof(T), alignof(T)>::type _cells[Capacity];
+
+            public:
+                explicit RingStorage(size_t) {}
+
+                size_t capacity() const { return Capacity; }
+
+                // 용량이 2의 거듭제곱이면 컴파일러가 % 를 mask 연산으로 바꾼다.
+                size_t index(size_t pos) const {
+                    return isPowerOfTwo(Capacity) ? (pos & (Capacity - 1)) : (pos % Capacity);
+                }
+
+                T* at(size_t pos) { return reinterpret_cast<T*>(&_cells[index(pos)]); }
+
+        }; // RingStorage
+
+
+        /**
+         * @brief 용량이 생성자에서 정해지는 경우의 저장 공간. 생성할 때 한 번만 할당한다.
+         */
+        template <typename T>
+        class RingStorage<T, DYNAMIC_CAPACITY> {
+
+            private:
+                typedef typename aligned_storage<sizeof(T), alignof(T)>::type Cell;
+
+                Cell* _cells;
+                const size_t _capacity;
+                const size_t _mask; // 용량이 2의 거듭제곱이 아니면 0
+
+            public:
+                explicit RingStorage(size_t n):
+                    _cells(new Cell[n]), _capacity(n), _mask(isPowerOfTwo(n) ? n - 1 : 0) {}
+
+                ~RingStorage() { delete [] _cells; }
+
+                RingStorage(const RingStorage&) = delete;
+                RingStorage& operator=(const RingStorage&) = delete;
+
+                size_t capacity() const { return _capacity; }
+
+                size_t index(size_t pos) const {
+                    return _mask ? (pos & _mask) : (pos % _capacity);
+                }
+
+                T* at(size_t pos) { return reinterpret_cast<T*>(&_cells[index(pos)]); }
+
+        }; // RingStorage<T, DYNAMIC_CAPACITY>
+
+    }; // detail
+
+
+    /**
+     * @brief 임의의 타입 T를 저장하는 RingBuffer.
+     *
+     * RingBuffer와 같은 4개의 함수를 같은 의미로 제공한다. 원소는 slot에 직접 생성되고(emplace)
+     * get은 원소를 move하여 반환하므로 move-only 타입이나 큰 구조체도 복사 없이 저장할 수 있다.
+     * Capacity를 지정하면 저장 공간이 객체 안에 포함되어 heap 할당이 없고,
+     * 용량이 2의 거듭제곱이면 index 계산에 % 대신 mask를 사용한다.
+     *
+     * @tparam T 저장할 원소의 타입
+     * @tparam Capacity 버퍼 크기. DYNAMIC_CAPACITY이면 생성자에서 정한다.
+     */
+    template <typename T, size_t Capacity = DYNAMIC_CAPACITY>
+    class TypedRingBuffer {
+
+        private:
+            detail::RingStorage<T, Capacity> _storage;
+            size_t _front; // 지금까지 저장된 원소 개수
+            size_t _back; // 지금까지 꺼낸 원소 개수
+            mutex _mutex;
+            condition_variable _notEmpty;
+            condition_variable _notFull;
+
+            bool isFull() const { return _front - _back == _storage.capacity(); }
+            bool isEmpty() const { return _front == _back; }
+
+            T take() {
+                T* pItem = _storage.at(_back);
+                T item(std::move(*pItem));
+                pItem->~T();
+                ++_back;
+                return item;
+            }
+
+        public:
+            /**
+             * @brief Capacity 크기의 버퍼를 만든다. Capacity가 DYNAMIC_CAPACITY이면 크기가 10이다.
+             */
+            TypedRingBuffer(): TypedRingBuffer(Capacity == DYNAMIC_CAPACITY ? 10 : Capacity) {}
+
+            /**
+             * @brief Creates a ring buffer of length n.
+             *
+             * @param n Buffer size. Capacity가 지정된 경우에는 무시된다.
+             */
+            explicit TypedRingBuffer(size_t n): _storage(n), _front(0), _back(0) {}
+
+            ~TypedRingBuffer() {
+                while (!isEmpty()) {
+                    _storage.at(_back)->~T();
+                    ++_back;
+                }
+            }
+
+            TypedRingBuffer(const TypedRingBuffer&) = delete;
+            TypedRingBuffer& operator=(const TypedRingBuffer&) = delete;
+
+
+            /**
+             * @brief 버퍼의 slot에 원소를 직접 생성한다. 빈 공간이 없으면 아무것도 하지 않는다.
+             *
+             * @param args T의 생성자에 전달할 인자.
+             */
+            template <typename... Args>
+            void emplace (Args&&... args) {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                if (isFull())
+                    return;
+
+                new (_storage.at(_front)) T(std::forward<Args>(args)...);
+                ++_front;
+                /* Critical section end */
+
+                lock.unlock();
+                _notEmpty.notify_one();
+            }
+
+
+            /**
+             * @brief 빈 공간이 생길 때까지 기다린 뒤 slot에 원소를 직접 생성한다.
+             *
+             * @param args T의 생성자에 전달할 인자.
+             */
+            template <typename... Args>
+            void emplaceWithoutOverride (Args&&... args) {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                _notFull.wait(lock, [this]() { return !isFull(); });
+
+                new (_storage.at(_front)) T(std::forward<Args>(args)...);
+                ++_front;
+                /* Critical section end */
+
+                lock.unlock();
+                _notEmpty.notify_one();
+            }
+
+
+            /**
+             * @brief 버퍼에 빈 공간이 없으면 값을 쓰지 않는다.
+             */
+            void put (const T& item) { emplace(item); }
+            void put (T&& item) { emplace(std::move(item)); }
+
+
+            /**
+             * @brief 데이터를 덮어쓰지 않고 빈 공간이 생길때까지 대기한다.
+             */
+            void putWithoutOverride (const T& item) { emplaceWithoutOverride(item); }
+            void putWithoutOverride (T&& item) { emplaceWithoutOverride(std::move(item)); }
+
+
+            /**
+             * @brief 버퍼에서 FIFO 방식으로 값을 꺼낸다. 버퍼가 비어있을 경우 EmptyBufferReadException을 던진다.
+             *
+             * @return 버퍼에서 move된 원소.
+             */
+            T get() {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                if (isEmpty()) {
+                    lock.unlock();
+                    throw EmptyBufferReadException();
+                }
+
+                T item(take());
+                /* Critical section end */
+
+                lock.unlock();
+                _notFull.notify_one();
+
+                return item;
+            }
+
+
+            /**
+             * @brief 버퍼가 비어 있는 경우 값이 저장될 때까지 기다린다.
+             *
+             * @return 버퍼에서 move된 원소.
+             */
+            T getFromNotEmptyBuffer() {
+
+                unique_lock<mutex> lock(_mutex);
+
+                /* Critical section start */
+                _notEmpty.wait(lock, [this]() { return !isEmpty(); });
+
+                T item(take());
+                /* Critical section end */
+
+                lock.unlock();
+                _notFull.notify_one();
+
+                return item;
+            }
+
+    }; // TypedRingBuffer
+
+}; // rtos
+
+#endif // _TYPED_RING_BUFFER_H_
@@ -0,0 +1,255 @@
+/**
+ * @file windowaggregate.cpp
+ * @brief Vectorized aggregate kernels over a window of int samples
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+
+#include <climits>
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define WINDOW_AGGREGATE_X86
+#endif
+
+#include "windowaggregate.h"
+
+
+namespace rtos {
+
+    // SIMD lane의 개수는 32bit이므로 이만큼씩 나누어 집계한다.
+    const size_t KERNEL_CHUNK = (size_t)1 << 30;
+
+
+    /**
+     * @brief 집계한 데이터가 없는 상태.
+     */
+    WindowAggregate emptyWindowAggregate() noexcept {
+
+        WindowAggregate aggregate;
+
+        aggregate.count = 0;
+        aggregate.sum = 0;
+        aggregate.min = INT_MAX;
+        aggregate.max = INT_MIN;
+        aggregate.aboveThreshold = 0;
+        aggregate.crossings = 0;
+        aggregate.isAbove = false;
+
+        return aggregate;
+    }
+
+
+    /**
+     * @brief 데이터 하나를 집계한다. 첫 데이터는 이전 값이 없으므로 crossing으로 세지 않는다.
+     */
+    static inline void step(int item, int threshold, WindowAggregate& aggregate) noexcept {
+
+        bool isAbove = item > threshold;
+
+        if (isAbove && !aggregate.isAbove && aggregate.count > 0)
+            ++aggregate.crossings;
+        aggregate.aboveThreshold += isAbove;
+        aggregate.isAbove = isAbove;
+        aggregate.sum += item;
+        aggregate.min = item < aggregate.min ? item : aggregate.min;
+        aggregate.max = item > aggregate.max ? item : aggregate.max;
+        ++aggregate.count;
+    }
+
+
+    static void accumulateScalar(const int* items, size_t n, int threshold, WindowAggregate& aggregate) noexcept {
+        for (size_t i=0; i<n; ++i)
+            step(items[i], threshold, aggregate);
+    }
+
+
+#ifdef WINDOW_AGGREGATE_X86
+
+    /**
+     * @brief 8개씩 집계한다. 이전 값과의 비교는 한 칸 앞에서 unaligned load한 vector로 한다.
+     */
+    __attribute__((target("avx2")))
+    static void accumulateAvx2(const int* items, size_t n, int threshold, WindowAggregate& aggregate) noexcept {
+
+        size_t i = 0;
+
+        while (n - i >= 9) {
+            // 첫 값의 이전 값은 앞 chunk나 앞 구간에 있으므로 aggregate.isAbove로 처리한다.
+            step(items[i], threshold, aggregate);
+            ++i;
+
+            size_t begin = i;
+            size_t end = i + (n - i < KERNEL_CHUNK ? n - i : KERNEL_CHUNK) / 8 * 8;
+            const __m256i vThreshold = _mm256_set1_epi32(threshold);
+            __m256i vSumLow = _mm256_setzero_si256();
+            __m256i vSumHigh = _mm256_setzero_si256();
+            __m256i vMin = _mm256_set1_epi32(aggregate.min);
+            __m256i vMax = _mm256_set1_epi32(aggregate.max);
+            __m256i vAbove = _mm256_setzero_si256();
+            __m256i vCrossings = _mm256_setzero_si256();
+
+            for (; i<end; i+=8) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(items + i));
+                __m256i vPrev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(items + i - 1));
+                __m256i isAbove = _mm256_cmpgt_epi32(v, vThreshold);
+                __m256i wasAbove = _mm256_cmpgt_epi32(vPrev, vThreshold);
+
+                vSumLow = _mm256_add_epi64(vSumLow, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+                vSumHigh = _mm256_add_epi64(vSumHigh, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+                vMin = _mm256_min_epi32(vMin, v);
+                vMax = _mm256_max_epi32(vMax, v);
+                vAbove = _mm256_sub_epi32(vAbove, isAbove); // 참이면 -1이므로 빼서 센다.
+                vCrossings = _mm256_sub_epi32(vCrossings, _mm256_andnot_si256(wasAbove, isAbove));
+            }
+
+            alignas(32) int64_t sums[8];
+            alignas(32) int mins[8];
+            alignas(32) int maxs[8];
+            alignas(32) uint32_t aboves[8];
+            alignas(32) uint32_t crossings[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(sums), vSumLow);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(sums + 4), vSumHigh);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(mins), vMin);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), vMax);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(aboves), vAbove);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(crossings), vCrossings);
+
+            for (size_t lane=0; lane<8; ++lane) {
+                aggregate.sum += sums[lane];
+                aggregate.min = mins[lane] < aggregate.min ? mins[lane] : aggregate.min;
+                aggregate.max = maxs[lane] > aggregate.max ? maxs[lane] : aggregate.max;
+                aggregate.aboveThreshold += aboves[lane];
+                aggregate.crossings += crossings[lane];
+            }
+            aggregate.count += end - begin;
+            aggregate.isAbove = items[end - 1] > threshold;
+        }
+
+        accumulateScalar(items + i, n - i, threshold, aggregate);
+    }
+
+
+    /**
+     * @brief accumulateAvx2와 같은 방법으로 4개씩 집계한다. min/max와 64bit 변환에 SSE4.1이 필요하다.
+     */
+    __attribute__((target("sse4.1")))
+    static void accumulateSse41(const int* items, size_t n, int threshold, WindowAggregate& aggregate) noexcept {
+
+        size_t i = 0;
+
+        while (n - i >= 5) {
+            step(items[i], threshold, aggregate);
+            ++i;
+
+            size_t begin = i;
+            size_t end = i + (n - i < KERNEL_CHUNK ? n - i : KERNEL_CHUNK) / 4 * 4;
+            const __m128i vThreshold = _mm_set1_epi32(threshold);
+            __m128i vSumLow = _mm_setzero_si128();
+            __m128i vSumHigh = _mm_setzero_si128();
+            __m128i vMin = _mm_set1_epi32(aggregate.min);
+            __m128i vMax = _mm_set1_epi32(aggregate.max);
+            __m128i vAbove = _mm_setzero_si128();
+            __m128i vCrossings = _mm_setzero_si128();
+
+            for (; i<end; i+=4) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(items + i));
+                __m128i vPrev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(items + i - 1));
+                __m128i isAbove = _mm_cmpgt_epi32(v, vThreshold);
+                __m128i wasAbove = _mm_cmpgt_epi32(vPrev, vThreshold);
+
+                vSumLow = _mm_add_epi64(vSumLow, _mm_cvtepi32_epi64(v));
+                vSumHigh = _mm_add_epi64(vSumHigh, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+                vMin = _mm_min_epi32(vMin, v);
+                vMax = _mm_max_epi32(vMax, v);
+                vAbove = _mm_sub_epi32(vAbove, isAbove);
+                vCrossings = _mm_sub_epi32(vCrossings, _mm_andnot_si128(wasAbove, isAbove));
+            }
+
+            alignas(16) int64_t sums[4];
+            alignas(16) int mins[4];
+            alignas(16) int maxs[4];
+            alignas(16) uint32_t aboves[4];
+            alignas(16) uint32_t crossings[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(sums), vSumLow);
+            _mm_store_si128(reinterpret_cast<__m128i*>(sums + 2), vSumHigh);
+            _mm_store_si128(reinterpret_cast<__m128i*>(mins), vMin);
+            _mm_store_si128(reinterpret_cast<__m128i*>(maxs), vMax);
+            _mm_store_si128(reinterpret_cast<__m128i*>(aboves), vAbove);
+            _mm_store_si128(reinterpret_cast<__m128i*>(crossings), vCrossings);
+
+            for (size_t lane=0; lane<4; ++lane) {
+                aggregate.sum += sums[lane];
+                aggregate.min = mins[lane] < aggregate.min ? mins[lane] : aggregate.min;
+                aggregate.max = maxs[lane] > aggregate.max ? maxs[lane] : aggregate.max;
+                aggregate.aboveThreshold += aboves[lane];
+                aggregate.crossings += crossings[lane];
+            }
+            aggregate.count += end - begin;
+            aggregate.isAbove = items[end - 1] > threshold;
+        }
+
+        accumulateScalar(items + i, n - i, threshold, aggregate);
+    }
+
+#endif // WINDOW_AGGREGATE_X86
+
+
+    typedef void (*WindowKernel)(const int*, size_t, int, WindowAggregate&);
+
+    /**@struct KernelChoice
+     * @brief 실행 중인 CPU에서 사용할 kernel. 처음 사용할 때 한 번 고른다.
+     */
+    typedef struct kernel_choice {
+        WindowKernel kernel;
+        const char* name;
+    } KernelChoice;
+
+
+    static KernelChoice chooseKernel() noexcept {
+
+        KernelChoice choice = { accumulateScalar, "scalar" };
+
+#ifdef WINDOW_AGGREGATE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            choice.kernel = accumulateAvx2;
+            choice.name = "avx2";
+        }
+        else if (__builtin_cpu_supports("sse4.1")) {
+            choice.kernel = accumulateSse41;
+            choice.name = "sse4.1";
+        }
+#endif
+
+        return choice;
+    }
+
+
+    static const KernelChoice& kernelChoice() noexcept {
+        static const KernelChoice choice = chooseKernel();
+        return choice;
+    }
+
+
+    /**
+     * @brief items[0..n)을 aggregate에 이어서 집계한다. CPU가 지원하는 가장 넓은 SIMD kernel을 사용한다.
+     *
+     * @param items 집계할 데이터
+     * @param n 데이터 개수
+     * @param threshold aboveThreshold, crossings의 기준값
+     * @param aggregate emptyWindowAggregate()로 시작하여 구간마다 갱신할 결과
+     */
+    void accumulateWindow(const int* items, size_t n, int threshold, WindowAggregate& aggregate) noexcept {
+        kernelChoice().kernel(items, n, threshold, aggregate);
+    }
+
+
+    /**
+     * @brief accumulateWindow가 사용하는 kernel의 이름. ("avx2", "sse4.1", "scalar")
+     */
+    const char* windowKernelName() noexcept {
+        return kernelChoice().name;
+    }
+
+}; // rtos
@@ -0,0 +1,52 @@
+/**
+ * @file windowaggregate.h
+ * @brief Vectorized aggregate kernels over a window of int samples
+ * @author 박민근
+ * @date 2023-06-06
+ */
+
+#ifndef _WINDOW_AGGREGATE_H_
+#define _WINDOW_AGGREGATE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+namespace rtos {
+
+    /**@struct WindowAggregate
+     * @brief 연속된 구간들에 대한 집계 결과. 구간을 순서대로 accumulateWindow에 넘기면 이어서 집계한다.
+     * @var WindowAggregate::count
+     * 집계한 데이터 개수. 0이면 나머지 값은 의미가 없다.
+     * @var WindowAggregate::sum
+     * 합. int의 합이 넘치지 않도록 64bit로 더한다.
+     * @var WindowAggregate::min
+     * 최솟값
+     * @var WindowAggregate::max
+     * 최댓값
+     * @var WindowAggregate::aboveThreshold
+     * threshold보다 큰 데이터 개수
+     * @var WindowAggregate::crossings
+     * threshold 이하에서 threshold보다 큰 값으로 바뀐 횟수
+     * @var WindowAggregate::isAbove
+     * 마지막 데이터가 threshold보다 컸는지. 다음 구간의 crossings 계산에 사용한다.
+     */
+    typedef struct window_aggregate {
+        size_t count;
+        int64_t sum;
+        int min;
+        int max;
+        size_t aboveThreshold;
+        size_t crossings;
+        bool isAbove;
+    } WindowAggregate;
+
+
+    WindowAggregate emptyWindowAggregate() noexcept;
+    void accumulateWindow(const int* items, size_t n, int threshold, WindowAggregate& aggregate) noexcept;
+    const char* windowKernelName() noexcept;
+
+}; // rtos
+
+#endif // _WINDOW_AGGREGATE_H_